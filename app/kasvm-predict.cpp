@@ -1,53 +1,334 @@
 #include <argtable2.h>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <math.h>
-#include <regex.h>
 #include <sstream>
 #include <stdio.h>
 #include <string.h>
 #include <memory>
+#include <omp.h>
 #include <svm.h>
 
-#include "partition/partition_config.h"
-#include "svm/svm_solver_libsvm.h"
-#include "svm/svm_solver_thunder.h"
+#include "io/feature_transform.h"
+#include "svm/dense_kernels.h"
 #include "svm/svm_convert.h"
-#include "svm/svm_result.h"
-#include "svm/results.h"
 #include "tools/timer.h"
-#include "parse_parameters.h"
 
-#include <thundersvm/util/log.h>
 void print_null(const char *s) {}
 
-#ifndef SVM_SOLVER
-#define SVM_SOLVER svm_solver_thunder
-#define SVM_MODEL SVC
-// #define SVM_SOLVER svm_solver_libsvm
-// #define SVM_MODEL svm_model
-#endif
+/*
+  Scores data with an exported model (libsvm format, which is also what
+  thundersvm and the dense solver write). The transformation 'prepare'
+  applied to the training data is read from its "_transform" file and
+  applied to every row, so raw csv/libsvm files can be scored directly.
 
-int main(int argn, char *argv[]) {
-	PartitionConfig partition_config;
+  The input is streamed in chunks: while one chunk is parsed and predicted
+  by all threads the next one is read from disk.
+*/
 
-        if(parse_parameters(argn, argv, partition_config)) {
+struct predict_config {
+        std::string model_file;
+        std::string input_file;
+        std::string output_file;
+        std::string transform_file;
+        bool libsvm = false;
+        bool format_given = false;
+        bool has_label = true;
+        bool decision_values = false;
+        size_t chunk_size = 65536;
+        int threads = 0;
+        // only used without transform file
+        int label_col = 0;
+        std::string label_min = "1";
+};
+
+int parse_args(int argc, char *argv[], predict_config & conf);
+
+struct chunk_result {
+        std::vector<int> labels;
+        std::vector<double> decision;
+        std::vector<int> truth;
+        // not vector<bool>, rows are parsed concurrently
+        std::vector<char> valid;
+};
+
+static std::vector<std::string> read_chunk(std::istream & in, size_t chunk_size) {
+        std::vector<std::string> lines;
+        lines.reserve(chunk_size);
+        for (std::string line; lines.size() < chunk_size && getline(in, line); ) {
+                // ignore comments and empty lines
+                if (line.empty() || line[0] == '#')
+                        continue;
+                lines.push_back(std::move(line));
+        }
+        return lines;
+}
+
+static void score_chunk(const std::vector<std::string> & lines, feature_transform & transform,
+                        const predict_config & conf, const svm_model * model,
+                        const dense_matrix_double * SV, chunk_result & result) {
+        size_t n = lines.size();
+        result.labels.assign(n, 0);
+        result.decision.assign(n, 0);
+        result.truth.assign(n, 0);
+        result.valid.assign(n, true);
+
+        dense_matrix_double X(n, SV ? SV->features : 0);
+        if (SV) {
+                X.rows = n;
+                X.values.resize(n * X.features);
+                X.norms.resize(n);
+        }
+
+#pragma omp parallel
+        {
+                FeatureVec row;
+                std::vector<double> dec(model->nr_class * (model->nr_class - 1) / 2);
+
+#pragma omp for schedule(static)
+                for (size_t i = 0; i < n; i++) {
+                        int label = 0;
+                        try {
+                                // without learning the transform is only read
+                                if (conf.libsvm) {
+                                        transform.parse_libsvm_row(lines[i], row, label, conf.has_label);
+                                } else {
+                                        transform.parse_csv_row(lines[i], row, label, false, conf.has_label);
+                                }
+                        } catch (...) {
+                                result.valid[i] = false;
+                                continue;
+                        }
+                        transform.apply(row);
+                        result.truth[i] = label;
+
+                        // same conversion as for the training data
+                        svm_feature nodes = svm_convert::feature_to_node(row);
+                        if (SV) {
+                                X.norms[i] = dense_matrix_double::fill_row(nodes.data(), X.features,
+                                                                           X.values.data() + i * X.features);
+                        } else {
+                                result.labels[i] = svm_predict_values(model, nodes.data(), dec.data());
+                                result.decision[i] = dec[0];
+                        }
+                }
+        }
+
+        if (SV) {
+                dense_kernels::rbf_decision(X, *SV, model->sv_coef[0], model->rho[0], model->param.gamma,
+                                            result.decision.data());
+                // same rule as svm_predict: a positive decision value votes for the first label
+                for (size_t i = 0; i < n; i++) {
+                        result.labels[i] = result.decision[i] > 0 ? model->label[0] : model->label[1];
+                }
+        }
+}
+
+int main(int argc, char *argv[]) {
+        predict_config conf;
+
+        if (parse_args(argc, argv, conf)) {
                 return -1;
         }
 
         // disable libsvm output
         svm_set_print_string_function(&print_null);
-	// disable thundersvm output
-	el::Loggers::reconfigureAllLoggers(el::ConfigurationType::Enabled, "false");
-
-	partition_config.apply();
-	partition_config.print();
-
-	/*
-	  We dream off a tool that takes a kasvm-model
-	  (maybe only the exported libsvm model)
-	  and evaluates it automaticaly on some data
-	  therefore the tool has to be aware of the transformations
-	  done by the 'prepare' tool and also apply these to the data.
-	*/	
+
+        if (conf.threads > 0) {
+                omp_set_num_threads(conf.threads);
+        }
+
+        feature_transform transform;
+        if (!conf.transform_file.empty()) {
+                if (!transform.load(conf.transform_file)) {
+                        return 1;
+                }
+                if (!conf.format_given) {
+                        conf.libsvm = transform.libsvm;
+                }
+        } else {
+                transform.label_col = conf.label_col;
+                transform.label_min = conf.label_min;
+        }
+
+        svm_model * model = svm_load_model(conf.model_file.c_str());
+        if (model == nullptr) {
+                std::cerr << "Error loading model " << conf.model_file << std::endl;
+                return 1;
+        }
+
+        // binary RBF models are scored blockwise on dense copies of the SVs and the samples,
+        // in double as svm_predict (and the libsvm backend of kasvm) so the labels agree
+        std::unique_ptr<dense_matrix_double> SV;
+        if (model->param.svm_type == C_SVC && model->param.kernel_type == RBF && model->nr_class == 2) {
+                SV.reset(new dense_matrix_double(dense_matrix_double::from_nodes(model->SV, model->l)));
+        }
+
+        std::ifstream in(conf.input_file);
+        if (!in) {
+                std::cerr << "Error opening file " << conf.input_file << std::endl;
+                return 1;
+        }
+        std::ofstream out(conf.output_file);
+        out << std::setprecision(8);
+
+        std::cout << "model " << conf.model_file << " SVs " << model->l
+                  << " kernel " << (SV ? "dense" : "libsvm") << std::endl;
+        std::cout << "threads " << omp_get_max_threads() << " chunk_size " << conf.chunk_size << std::endl;
+
+        timer t;
+        double read_time = 0;
+        size_t rows = 0;
+        size_t invalid = 0;
+        size_t tp = 0, fn = 0, tn = 0, fp = 0;
+
+        std::vector<std::string> lines = read_chunk(in, conf.chunk_size);
+
+        // csv without transform: the column types are taken from the first row
+        if (!conf.libsvm && transform.col_typs.empty() && !lines.empty()) {
+                transform.detect_columns(lines[0], conf.has_label);
+        }
+
+        chunk_result result;
+        while (!lines.empty()) {
+                auto next = std::async(std::launch::async, read_chunk, std::ref(in), conf.chunk_size);
+
+                score_chunk(lines, transform, conf, model, SV.get(), result);
+
+                for (size_t i = 0; i < lines.size(); i++) {
+                        if (!result.valid[i]) {
+                                invalid++;
+                                out << "?\n";
+                                continue;
+                        }
+                        out << result.labels[i];
+                        if (conf.decision_values) {
+                                out << " " << result.decision[i];
+                        }
+                        out << "\n";
+
+                        if (conf.has_label) {
+                                bool predicted_min = result.labels[i] == 1;
+                                if (result.truth[i] == 1) {
+                                        predicted_min ? tp++ : fn++;
+                                } else {
+                                        predicted_min ? fp++ : tn++;
+                                }
+                        }
+                }
+                rows += lines.size();
+
+                timer wait;
+                lines = next.get();
+                read_time += wait.elapsed();
+        }
+        out.close();
+
+        double time = t.elapsed();
+
+        std::cout << "rows " << rows << " invalid " << invalid << std::endl;
+        std::cout << "predict time " << time << " (waiting for input " << read_time << ")" << std::endl;
+        std::cout << "rows/s " << std::fixed << std::setprecision(0) << (time > 0 ? rows / time : 0) << std::endl;
+        std::cout.unsetf(std::ios_base::floatfield);
+        std::cout << std::setprecision(6);
+
+        if (conf.has_label && rows > invalid) {
+                double sens = tp + fn > 0 ? (double) tp / (tp + fn) : 0;
+                double spec = tn + fp > 0 ? (double) tn / (tn + fp) : 0;
+                std::cout << "ACC " << (double) (tp + tn) / (rows - invalid) << std::endl;
+                std::cout << "SN " << sens << std::endl;
+                std::cout << "SP " << spec << std::endl;
+                std::cout << "Gmean " << sqrt(sens * spec) << std::endl;
+        }
+
+        std::cout << "predictions written to " << conf.output_file << std::endl;
+
+        svm_free_and_destroy_model(&model);
+        return 0;
+}
+
+int parse_args(int argc, char *argv[], predict_config & conf) {
+        // Setup argtable parameters.
+        struct arg_end *end                 = arg_end(100);
+        struct arg_lit *help                = arg_lit0("h", "help","Print help.");
+        struct arg_str *filename_model      = arg_strn(NULL, NULL, "MODEL", 1, 1, "Path to the exported model (libsvm format).");
+        struct arg_str *filename            = arg_strn(NULL, NULL, "FILE", 1, 1, "Path to the csv/libsvm file to score.");
+        struct arg_str *filename_transform  = arg_str0("t", "transform", "TRANSFORM", "The \"_transform\" file written by prepare for the training data. Without it the rows are used as they are.");
+        struct arg_str *filename_output     = arg_str0("o", "output_filename", "OUTPUT", "Where to write the predictions, one per line. default: FILE.predict");
+        struct arg_str *file_format         = arg_str0(NULL, "file_format", "[csv|libsvm]", "The format of the input file (default: the one of the transform, otherwise csv if the file ends with \".csv\")");
+        struct arg_int *label_column        = arg_int0(NULL, "label_col", NULL, "column in which the labels are written (starting at 0), only without transform");
+        struct arg_str *label_minority      = arg_str0(NULL, "minority", NULL, "label/class of the minority class (default \"1\"), only without transform");
+        struct arg_lit *no_labels           = arg_lit0(NULL, "no_labels", "the rows have no label column");
+        struct arg_lit *decision_values     = arg_lit0(NULL, "decision_values", "also write the decision value of every row");
+        struct arg_int *chunk_size          = arg_int0(NULL, "chunk_size", NULL, "rows read and scored at once (default 65536)");
+        struct arg_int *threads             = arg_int0(NULL, "threads", NULL, "number of threads (default: all)");
+
+        void* argtable[] = {help, filename_model, filename, filename_transform, filename_output, file_format,
+                            label_column, label_minority, no_labels, decision_values, chunk_size, threads
+                            ,end};
+
+        // Parse arguments.
+        int nerrors = arg_parse(argc, argv, argtable);
+
+        const char *progname = argv[0];
+
+        // help or error
+        if (nerrors > 0 || help->count > 0) {
+                printf("Usage: %s", progname);
+                arg_print_syntax(stdout, argtable, "\n");
+                arg_print_glossary(stdout, argtable,"  %-40s %s\n");
+                arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+                return 1;
+        }
+
+        conf.model_file = filename_model->sval[0];
+        conf.input_file = filename->sval[0];
+        conf.output_file = conf.input_file + ".predict";
+        conf.libsvm = !(conf.input_file.size() >= 4
+                        && conf.input_file.substr(conf.input_file.size()-4, 4) == ".csv");
+
+        if (filename_transform->count > 0) {
+                conf.transform_file = filename_transform->sval[0];
+        }
+
+        if (filename_output->count > 0) {
+                conf.output_file = filename_output->sval[0];
+        }
+
+        if (label_column->count > 0) {
+                conf.label_col = label_column->ival[0];
+        }
+
+        if (label_minority->count > 0) {
+                conf.label_min = label_minority->sval[0];
+        }
+
+        if (no_labels->count > 0) {
+                conf.has_label = false;
+        }
+
+        if (decision_values->count > 0) {
+                conf.decision_values = true;
+        }
+
+        if (chunk_size->count > 0 && chunk_size->ival[0] > 0) {
+                conf.chunk_size = chunk_size->ival[0];
+        }
+
+        if (threads->count > 0) {
+                conf.threads = threads->ival[0];
+        }
+
+        // an explicit format wins over the one of the transform
+        if (file_format->count > 0) {
+                conf.libsvm = std::string("csv") != file_format->sval[0];
+                conf.format_given = true;
+        }
+
+        arg_freetable(argtable,sizeof(argtable)/sizeof(argtable[0]));
+
+        return 0;
 }
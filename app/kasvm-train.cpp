@@ -7,15 +7,19 @@
 #include <stdio.h>
 #include <string.h>
 #include <memory>
+#include <algorithm>
+#include <chrono>
 #include <svm.h>
 
 #include "data_structure/graph_access.h"
 #include "data_structure/graph_hierarchy.h"
 #include "io/graph_io.h"
 #include "partition/coarsening/coarsening.h"
+#include "partition/coarsening/clustering/size_constraint_label_propagation.h"
 #include "partition/partition_config.h"
 #include "svm/svm_solver_libsvm.h"
 #include "svm/svm_solver_thunder.h"
+#include "svm/svm_solver_dense.h"
 #include "svm/svm_convert.h"
 #include "svm/k_fold.h"
 #include "svm/k_fold_build.h"
@@ -38,6 +42,8 @@ void print_null(const char *s) {}
 #define SVM_MODEL SVC
 // #define SVM_SOLVER svm_solver_libsvm
 // #define SVM_MODEL svm_model
+// #define SVM_SOLVER svm_solver_dense
+// #define SVM_MODEL dense_model
 #endif
 
 int main(int argn, char *argv[]) {
@@ -87,6 +93,7 @@ int main(int argn, char *argv[]) {
 
         while (kfold->next(kfold_io_time)) {
         results.next();
+        svm_result_cache_stats::reset();
 
         graph_access *G_min = kfold->getMinGraph();
         graph_access *G_maj = kfold->getMajGraph();
@@ -121,8 +128,12 @@ int main(int argn, char *argv[]) {
         graph_hierarchy min_hierarchy;
         graph_hierarchy maj_hierarchy;
 
+        label_propagation_stats::reset();
         coarsen.perform_coarsening(partition_config, *G_min, min_hierarchy);
+        std::vector<label_propagation_run> lp_min = label_propagation_stats::runs();
+        label_propagation_stats::reset();
         coarsen.perform_coarsening(partition_config, *G_maj, maj_hierarchy);
+        std::vector<label_propagation_run> lp_maj = label_propagation_stats::runs();
 
         auto coarsening_time = t.elapsed();
         std::cout << "coarsening time: " << coarsening_time << std::endl
@@ -135,6 +146,17 @@ int main(int argn, char *argv[]) {
         results.setFloat("HIERARCHY_MIN_SIZE", min_hierarchy.size());
         results.setFloat("HIERARCHY_MAJ_SIZE", maj_hierarchy.size());
 
+        // label propagation rounds and visited nodes per coarsening level
+        for (const auto & lp : { std::make_pair("MIN", &lp_min), std::make_pair("MAJ", &lp_maj) }) {
+                for (size_t i = 0; i < lp.second->size(); i++) {
+                        std::ostringstream fmt_it, fmt_visited;
+                        fmt_it << "LP_" << lp.first << i << "_ITERATIONS";
+                        fmt_visited << "LP_" << lp.first << i << "_VISITED";
+                        results.setFloat(fmt_it.str(), (*lp.second)[i].iterations);
+                        results.setFloat(fmt_visited.str(), (*lp.second)[i].visited);
+                }
+        }
+
 
         int init_level = std::max(min_hierarchy.size(), maj_hierarchy.size());
 	if (partition_config.export_graph) {
@@ -155,6 +177,9 @@ int main(int argn, char *argv[]) {
         initial_instance.read_problem(*min_hierarchy.get_coarsest(), *maj_hierarchy.get_coarsest());
 
         SVM_SOLVER init_solver(initial_instance);
+        init_solver.set_parallelism(partition_config.sweep_candidates, partition_config.sweep_threads);
+        init_solver.set_racing(partition_config.race_fraction);
+        init_solver.set_early_exit(partition_config.early_exit);
 
 	svm_result<SVM_MODEL> initial_result(initial_instance);
 
@@ -171,7 +196,8 @@ int main(int argn, char *argv[]) {
 									  *kfold->getMajValData(),
 									  state,
 									  partition_config.bayes_init,
-									  partition_config.seed);
+									  partition_config.seed,
+									  partition_config.bayes_batch);
 		break;
 	case FIX:
 		initial_result = fix_refinement<SVM_MODEL>::train_fix(init_solver,
@@ -228,6 +254,9 @@ int main(int argn, char *argv[]) {
 		break;
 	}
 
+        // the level is done, its instance is only kept for the final model
+        initial_instance.release_caches();
+
 	std::vector<std::pair<svm_summary<SVM_MODEL>, svm_instance>> best_results;
         best_results.push_back(std::make_pair(initial_summary, initial_instance));
 
@@ -240,8 +269,17 @@ int main(int argn, char *argv[]) {
                 std::cout << "refinement at level " << refinement->get_level()
                         << " took " << t_ref.elapsed() << std::endl;
 
+                current_result.instance.release_caches();
                 best_results.push_back(std::make_pair(current_result.best(), current_result.instance));
 
+                // only the best level so far can still be chosen, the others keep their scores
+                size_t best_so_far = svm_result<SVM_MODEL>::get_best_index(best_results);
+                for (size_t i = 0; i < best_results.size(); i++) {
+                        if (i != best_so_far) {
+                                best_results[i].first.drop_model();
+                        }
+                }
+
                 std::ostringstream fmt_ac, fmt_gm;
                 fmt_ac << "LEVEL" << refinement->get_level() << "_AC";
                 fmt_gm << "LEVEL" << refinement->get_level() << "_GM";
@@ -277,6 +315,8 @@ int main(int argn, char *argv[]) {
         auto refinement_time = t.elapsed();
         std::cout << "refinement time " << refinement_time << std::endl;
         results.setFloat("\tREFINEMENT_TIME", refinement_time);
+        results.setFloat("RESULT_CACHE_HITS", svm_result_cache_stats::hits());
+        results.setFloat("RESULT_CACHE_MISSES", svm_result_cache_stats::misses());
 
         int best_index = svm_result<SVM_MODEL>::get_best_index(best_results);
         results.setString("BEST_INDEX", std::to_string(best_index));
@@ -288,14 +328,61 @@ int main(int argn, char *argv[]) {
         results.setFloat("BEST_GM", best_summary.Gmean);
         results.setFloat("BEST_F1", best_summary.F1);
 
-        // ------------ TEST --------------
-        t.restart();
-
-        std::cout << "best validation on testing data:" << std::endl;
         SVM_SOLVER best_solver(best_results[best_index].second);
         best_solver.set_C(best_summary.C);
         best_solver.set_gamma(best_summary.gamma);
         best_solver.set_model(best_summary.model);
+
+        // ------------ COMPACTION --------------
+        if (partition_config.compact_budget > 0 || partition_config.compact_max_loss > 0) {
+                t.restart();
+
+                const svm_data & min_val = *kfold->getMinValData();
+                const svm_data & maj_val = *kfold->getMajValData();
+
+                auto before = best_solver.build_summary(min_val, maj_val);
+                auto accepted = before;
+                size_t num_SV = before.num_SV_min() + before.num_SV_maj();
+                size_t budget = std::max(partition_config.compact_budget, 2);
+
+                // with a loss bound the SVs are halved as long as the validation Gmean allows it,
+                // otherwise the model is merged down to the budget at once
+                size_t target = partition_config.compact_max_loss > 0 ? std::max(budget, num_SV / 2) : budget;
+                while (target < accepted.num_SV_min() + accepted.num_SV_maj()) {
+                        if (!best_solver.compact(target)) {
+                                std::cout << "compaction is not supported by this solver" << std::endl;
+                                break;
+                        }
+
+                        auto current = best_solver.build_summary(min_val, maj_val);
+                        if (partition_config.compact_max_loss > 0
+                            && before.Gmean - current.Gmean > partition_config.compact_max_loss) {
+                                best_solver.set_model(accepted.model);
+                                break;
+                        }
+                        accepted = current;
+
+                        if (target == budget) {
+                                break;
+                        }
+                        target = std::max(budget, target / 2);
+                }
+
+                auto compact_time = t.elapsed();
+                std::cout << "compaction SVs " << num_SV << " -> " << accepted.num_SV_min() + accepted.num_SV_maj()
+                          << " validation Gmean " << before.Gmean << " -> " << accepted.Gmean
+                          << " took " << compact_time << std::endl;
+                results.setFloat("\tCOMPACT_TIME", compact_time);
+                results.setFloat("COMPACT_SV_BEFORE", num_SV);
+                results.setFloat("COMPACT_SV_AFTER", accepted.num_SV_min() + accepted.num_SV_maj());
+                results.setFloat("COMPACT_GM_BEFORE", before.Gmean);
+                results.setFloat("COMPACT_GM_AFTER", accepted.Gmean);
+        }
+
+        // ------------ TEST --------------
+        t.restart();
+
+        std::cout << "best validation on testing data:" << std::endl;
         auto best_summary_test = best_solver.build_summary(*kfold->getMinTestData(), *kfold->getMajTestData());
         auto test_time = t.elapsed();
         std::cout << "test time " << test_time << std::endl;
@@ -308,6 +395,28 @@ int main(int argn, char *argv[]) {
         results.setFloat("BEST_GM_TEST", best_summary_test.Gmean);
         results.setFloat("BEST_F1_TEST", best_summary_test.F1);
 
+        if (partition_config.predict_latency) {
+                // one request at a time, as a per event scoring service would see it
+                std::vector<double> latencies;
+                for (const svm_data * data : { kfold->getMinTestData(), kfold->getMajTestData() }) {
+                        for (const auto & sample : *data) {
+                                auto start = std::chrono::steady_clock::now();
+                                best_solver.predict(sample);
+                                auto end = std::chrono::steady_clock::now();
+                                latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+                        }
+                }
+
+                if (!latencies.empty()) {
+                        std::sort(latencies.begin(), latencies.end());
+                        double p50 = latencies[(latencies.size() - 1) * 50 / 100];
+                        double p99 = latencies[(latencies.size() - 1) * 99 / 100];
+                        std::cout << "predict latency p50 " << p50 << "us p99 " << p99 << "us" << std::endl;
+                        results.setFloat("PREDICT_P50_US", p50);
+                        results.setFloat("PREDICT_P99_US", p99);
+                }
+        }
+
         // ------------- END --------------
         auto time_all = t_all.elapsed();
 
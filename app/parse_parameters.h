@@ -61,6 +61,9 @@ int parse_parameters(int argn, char **argv,
         // label propagation
         struct arg_int *cluster_upperbound                   = arg_int0(NULL, "cluster_upperbound", NULL, "Set a size-constraint on the size of a cluster. Default: none");
         struct arg_int *label_propagation_iterations         = arg_int0(NULL, "label_propagation_iterations", NULL, "Set the number of label propgation iterations. Default: 10.");
+        struct arg_lit *lp_active_set                        = arg_lit0(NULL, "lp_active_set", "Only revisit nodes whose neighbours changed their cluster in the previous label propagation round.");
+        struct arg_dbl *lp_stop_fraction                     = arg_dbl0(NULL, "lp_stop_fraction", NULL, "Stop label propagation once fewer than this fraction of the nodes changed their cluster in a round. Default: 0 (run all iterations).");
+        struct arg_lit *parallel_lp                          = arg_lit0(NULL, "parallel_lp", "Run label propagation on all threads for large graphs. Faster, but the clustering depends on the thread schedule and is not reproducible.");
 
         // low_diameter
         struct arg_dbl *diameter_upperbound                  = arg_dbl0(NULL, "diameter_upperbound", NULL, "Set a size-constraint on the size of a low diameter cluster. Default: 20");
@@ -83,6 +86,22 @@ int parse_parameters(int argn, char **argv,
 	struct arg_dbl *beta                                 = arg_dbl0(NULL, "beta", NULL, "value of the beta parameter when using low diameter clustering. (Default: 0.4)");
         struct arg_int *num_skip_ms                          = arg_int0(NULL, "num_skip_ms", NULL, "Size of the problem on which no model selection is skipped and only the best parameters of the previous level are used (Default: 10000)");
         struct arg_lit *no_inherit_ud                        = arg_lit0(NULL, "no_inherit_ud", "Don't inherit the first UD sweep and do only the second UD sweep in the refinement.");
+        struct arg_int *sweep_candidates                     = arg_int0(NULL, "sweep_candidates", NULL, "Number of parameter candidates of a sweep that are trained concurrently (Default: 1)");
+        struct arg_int *sweep_threads                        = arg_int0(NULL, "sweep_threads", NULL, "Number of threads used by a single candidate of a sweep (Default: 0 aka. cores / sweep_candidates)");
+        struct arg_lit *no_warm_start                        = arg_lit0(NULL, "no_warm_start", "Don't seed the training on a refinement level with the alphas of the coarser level.");
+        struct arg_int *distance_cache_mb                    = arg_int0(NULL, "distance_cache_mb", NULL, "Memory in MB for the squared distances shared by all candidates of a sweep, 0 disables the cache (Default: 512)");
+        struct arg_lit *no_result_cache                      = arg_lit0(NULL, "no_result_cache", "Train a (C, gamma) pair again even if it was already trained on the same level.");
+        struct arg_int *result_models                        = arg_int0(NULL, "result_models", NULL, "Number of candidates of a level that keep their models, the others only keep their scores (Default: 4, 0 aka. all)");
+        struct arg_lit *predict_latency                      = arg_lit0(NULL, "predict_latency", "Measure the latency of single sample predictions of the best model on the test data.");
+        struct arg_int *bayes_batch                          = arg_int0(NULL, "bayes_batch", NULL, "Number of bayesian optimization proposals trained concurrently (constant liar), at most half of the optimization steps (Default: 1 aka. sequential)");
+        struct arg_dbl *race_fraction                        = arg_dbl0(NULL, "race_fraction", NULL, "Score the candidates of a sweep on this fraction of the validation data first and only the ones that may beat the leader on all of it (Default: 0 aka. off)");
+        struct arg_lit *no_early_exit                        = arg_lit0(NULL, "no_early_exit", "Score every candidate of a sweep on all validation data, even if it can't come close to the best one anymore.");
+        struct arg_int *compact_budget                       = arg_int0(NULL, "compact_budget", NULL, "Merge SVs of the final model until at most this many are left (Default: 0 aka. off)");
+        struct arg_dbl *compact_max_loss                     = arg_dbl0(NULL, "compact_max_loss", NULL, "Merge SVs of the final model as long as the validation Gmean drops by at most this much (Default: 0 aka. off)");
+        struct arg_int *approx_threshold                     = arg_int0(NULL, "approx_threshold", NULL, "Train levels with at least this many rows on an explicit feature map with a linear solver, dense solver only (Default: 0 aka. off)");
+        struct arg_rex *approx_type                          = arg_rex0(NULL, "approx_type", "^(rff|nystroem)$", "TYPE", REG_EXTENDED, "Feature map of the approximate training. One of {rff, nystroem}, nystroem uses SVs and nodes of the coarser level as landmarks (Default: rff)");
+        struct arg_int *approx_dim                           = arg_int0(NULL, "approx_dim", NULL, "Number of random features or landmarks of the approximate training (Default: 512)");
+        struct arg_lit *approx_orthogonal                    = arg_lit0(NULL, "approx_orthogonal", "Use orthogonal random features for the approximate training.");
 
         struct arg_end *end                                  = arg_end(100);
 
@@ -105,6 +124,9 @@ int parse_parameters(int argn, char **argv,
                             matching_type,
                             cluster_upperbound,
                             label_propagation_iterations,
+                            lp_active_set,
+                            lp_stop_fraction,
+                            parallel_lp,
                             diameter_upperbound,
 			    beta,
 			    refinement_type,
@@ -112,6 +134,22 @@ int parse_parameters(int argn, char **argv,
 			    fix_gamma,
                             num_skip_ms,
                             no_inherit_ud,
+                            sweep_candidates,
+                            sweep_threads,
+                            no_warm_start,
+                            distance_cache_mb,
+                            no_result_cache,
+                            result_models,
+                            predict_latency,
+                            bayes_batch,
+                            race_fraction,
+                            no_early_exit,
+                            compact_budget,
+                            compact_max_loss,
+                            approx_threshold,
+                            approx_type,
+                            approx_dim,
+                            approx_orthogonal,
 			    export_graph,
                             filename_output,
 			    export_model_path,
@@ -285,6 +323,18 @@ int parse_parameters(int argn, char **argv,
                 partition_config.label_iterations = label_propagation_iterations->ival[0];
         }
 
+        if (lp_active_set->count > 0) {
+                partition_config.lp_active_set = true;
+        }
+
+        if (lp_stop_fraction->count > 0) {
+                partition_config.lp_stop_fraction = lp_stop_fraction->dval[0];
+        }
+
+        if (parallel_lp->count > 0) {
+                partition_config.parallel_lp = true;
+        }
+
         if (cluster_upperbound->count > 0) {
                 partition_config.cluster_upperbound = cluster_upperbound->ival[0];
         }
@@ -351,6 +401,74 @@ int parse_parameters(int argn, char **argv,
                 partition_config.inherit_ud = false;
         }
 
+        if(sweep_candidates->count > 0) {
+                partition_config.sweep_candidates = sweep_candidates->ival[0];
+        }
+
+        if(sweep_threads->count > 0) {
+                partition_config.sweep_threads = sweep_threads->ival[0];
+        }
+
+        if(no_warm_start->count > 0) {
+                partition_config.warm_start = false;
+        }
+
+        if(distance_cache_mb->count > 0) {
+                partition_config.distance_cache_mb = distance_cache_mb->ival[0];
+        }
+
+        if(no_result_cache->count > 0) {
+                partition_config.result_cache = false;
+        }
+
+        if(result_models->count > 0) {
+                partition_config.result_models = result_models->ival[0];
+        }
+
+        if(predict_latency->count > 0) {
+                partition_config.predict_latency = true;
+        }
+
+        if(bayes_batch->count > 0) {
+                partition_config.bayes_batch = bayes_batch->ival[0];
+        }
+
+        if(race_fraction->count > 0) {
+                partition_config.race_fraction = race_fraction->dval[0];
+        }
+
+        if(no_early_exit->count > 0) {
+                partition_config.early_exit = false;
+        }
+
+        if(compact_budget->count > 0) {
+                partition_config.compact_budget = compact_budget->ival[0];
+        }
+
+        if(compact_max_loss->count > 0) {
+                partition_config.compact_max_loss = compact_max_loss->dval[0];
+        }
+
+        if(approx_threshold->count > 0) {
+                partition_config.approx_threshold = approx_threshold->ival[0];
+        }
+
+        if(approx_type->count > 0) {
+                if (strcmp("nystroem", approx_type->sval[0]) == 0) {
+                        partition_config.approx_type = APPROX_NYSTROEM;
+                } else {
+                        partition_config.approx_type = APPROX_RFF;
+                }
+        }
+
+        if(approx_dim->count > 0 && approx_dim->ival[0] > 0) {
+                partition_config.approx_dim = approx_dim->ival[0];
+        }
+
+        if(approx_orthogonal->count > 0) {
+                partition_config.approx_orthogonal = true;
+        }
+
         if(timeout->count > 0) {
                 partition_config.timeout = timeout->ival[0];
         }
@@ -8,6 +8,7 @@
 #include <cctype>
 #include <locale>
 #include <argtable2.h>
+#include "io/feature_transform.h"
 #include "svm/svm_flann.h"
 #include "tools/timer.h"
 #include "definitions.h"
@@ -17,55 +18,13 @@ using namespace std;
 typedef vector<FeatureVec> MyMat;
 
 
-// trim from start (in place)
-static inline void ltrim(std::string &s) {
-        s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](int ch) {
-                                return !std::isspace(ch);
-                        }));
-}
-
-// trim from end (in place)
-static inline void rtrim(std::string &s) {
-        s.erase(std::find_if(s.rbegin(), s.rend(), [](int ch) {
-                                return !std::isspace(ch);
-                        }).base(), s.end());
-}
-
-// trim from both ends (in place)
-static inline void trim(std::string &s) {
-        ltrim(s);
-        rtrim(s);
-}
-
-// trim from start (copying)
-static inline std::string ltrim_copy(std::string s) {
-        ltrim(s);
-        return s;
-}
-
-// trim from end (copying)
-static inline std::string rtrim_copy(std::string s) {
-        rtrim(s);
-        return s;
-}
-
-// trim from both ends (copying)
-static inline std::string trim_copy(std::string s) {
-        trim(s);
-        return s;
-}
-
-enum NORMALIZE_METHOD {
-	NONE, LINEAR, GAUSS_NORM
-};
-
 struct config {
 	int nn_num = 10;
 	int label_col = 0;
 	string label_min = "1";
 	//indicates whether to normalize or scale to [0,1] or neither
 	//scaling can preserve null entries
-	NORMALIZE_METHOD norm = GAUSS_NORM;
+	feature_transform::METHOD norm = feature_transform::GAUSS_NORM;
 	// read libsvm data instead of csv
 	bool libsvm = false;
 	bool processed_csv = false;
@@ -75,16 +34,12 @@ struct config {
 
 int parse_args(int argc, char *argv[], config & conf);
 
-void read_csv(const string & filename, MyMat & min_data, vector<int> & maj_data, int label_col = 0, const string & label_min = "-1");
+void read_csv(const string & filename, MyMat & data, vector<int> & labels, feature_transform & transform);
 
-void read_libsvm(const string & filename, MyMat & data, vector<int> & labels, const string & label_min);
+void read_libsvm(const string & filename, MyMat & data, vector<int> & labels, const feature_transform & transform);
 
 void write_csv(const string & filename, const MyMat & data, const vector<int> & labels);
 
-void normalize(MyMat & data);
-
-void scale(MyMat & data);
-
 void split(const MyMat & data, const vector<int> labels, MyMat & min, MyMat & maj);
 
 void write_metis(const vector<vector<Edge>> & edges, const string output);
@@ -102,13 +57,19 @@ int main(int argc, char *argv[]) {
         MyMat data;
         vector<int> labels;
 
+        feature_transform transform;
+        transform.method = conf.norm;
+        transform.libsvm = conf.libsvm;
+        transform.label_col = conf.label_col;
+        transform.label_min = conf.label_min;
+
         timer t;
 
         if (conf.libsvm) {
-                read_libsvm(conf.inputfile, data, labels, conf.label_min);
+                read_libsvm(conf.inputfile, data, labels, transform);
                 cout << "read libsvm time " << t.elapsed() << endl;
         } else {
-                read_csv(conf.inputfile, data, labels, conf.label_col, conf.label_min);
+                read_csv(conf.inputfile, data, labels, transform);
                 cout << "read csv time " << t.elapsed() << endl;
         }
 
@@ -123,19 +84,22 @@ int main(int argc, char *argv[]) {
 
         t.restart();
 
+        transform.fit(data);
+
 	switch (conf.norm) {
-	case GAUSS_NORM:
-                normalize(data);
+	case feature_transform::GAUSS_NORM:
                 cout << "normalization time " << t.elapsed() << endl;
 		break;
-	case LINEAR:
-                scale(data);
+	case feature_transform::LINEAR:
                 cout << "scale time " << t.elapsed() << endl;
 		break;
-	case NONE:
+	case feature_transform::NONE:
 		break;
 	}
 
+        // kasvm-predict needs this to treat new data the same way
+        transform.save(conf.outputfile + "_transform");
+
         MyMat min_data;
         MyMat maj_data;
 
@@ -215,11 +179,11 @@ int parse_args(int argc, char *argv[], config & conf) {
         }
 
         if (scale->count > 0) {
-                conf.norm = LINEAR;
+                conf.norm = feature_transform::LINEAR;
         } else if (no_scale->count > 0) {
-                conf.norm = NONE;
+                conf.norm = feature_transform::NONE;
         } else {
-		conf.norm = GAUSS_NORM;
+		conf.norm = feature_transform::GAUSS_NORM;
 	}
 
         if (p_csv->count > 0) {
@@ -261,120 +225,40 @@ int parse_args(int argc, char *argv[], config & conf) {
         return 0;
 }
 
-void read_csv(const string & filename, MyMat & data, vector<int> & labels, int label_col, const string & label_min) {
-        enum COL_TYP {
-                LABEL,
-                NUMERICAL,
-                CATEGORICAL
-        };
-
-        std::vector<std::vector<std::string>> col_categorical_value;
-        std::vector<COL_TYP> col_typs;
-
+void read_csv(const string & filename, MyMat & data, vector<int> & labels, feature_transform & transform) {
         bool first = true;
 
         ifstream file;
         file.open(filename);
         for (string line; getline(file, line); ) {
-                stringstream sep(line);
-
                 // ignore comments
                 if (line[0] == '#')
                         continue;
 
-
                 if (first == true) {
                         // scan over the first entry to get column information
-                        size_t col = 0;
-                        for (string item; getline(sep, item, ','); ) {
-                                try {
-                                        stod(item);
-                                        col_typs.push_back(NUMERICAL);
-                                } catch (...) {
-                                        col_typs.push_back(CATEGORICAL);
-                                }
-                                col++;
-                        }
-                        col_typs[label_col] = LABEL;
-                        col_categorical_value.resize(col);
-
-                        sep.clear();
-                        sep.seekg(0);
+                        transform.detect_columns(line);
                         first = false;
                 }
 
+                int label;
                 data.push_back(FeatureVec());
-                size_t col=0;
-                for (string item; getline(sep, item, ','); ) {
-                        switch (col_typs[col]) {
-			case LABEL:
-				{
-					if (item == label_min) {
-						labels.push_back(1);
-					} else {
-						labels.push_back(-1);
-					}
-					// int label = stoi(item);
-                                        // labels.push_back(label);
-                                        break;
-                                }
-
-                        case NUMERICAL:
-                                {
-                                        trim(item);
-                                        if (item == "?" || item == "na") {
-                                                data.back().push_back(-1);
-                                        }
-                                        FeatureData val = stod(item);
-                                        data.back().push_back(val);
-                                        break;
-                                }
-
-                        case CATEGORICAL:
-                                {
-                                        // convert categorical attributes to integers
-                                        int cat = -1;
-                                        for (size_t i = 0; i < col_categorical_value[col].size(); i++) {
-                                                if (col_categorical_value[col][i] == item) {
-                                                        cat = i;
-                                                        break;
-                                                }
-                                        }
-                                        if (cat == -1) {
-                                                cat = col_categorical_value[col].size();
-                                                col_categorical_value[col].push_back(item);
-                                        }
-                                        data.back().push_back(cat);
-                                        break;
-                                }
-                        }
-                        col++;
-                }
+                transform.parse_csv_row(line, data.back(), label, true);
+                labels.push_back(label);
         }
 
-        for (size_t col = 0; col < col_categorical_value.size(); col++) {
-                if (col_typs[col] != CATEGORICAL)
+        for (size_t col = 0; col < transform.col_categorical_value.size(); col++) {
+                if (transform.col_typs[col] != feature_transform::CATEGORICAL)
                         continue;
                 cout << "Categorical values for col " << col << endl;
-                for (const string & v : col_categorical_value[col]) {
+                for (const string & v : transform.col_categorical_value[col]) {
                         cout << v << ",";
                 }
                 cout << endl;
         }
-
-
-        // convert categorical attributes to binary
-        for (size_t row = 0; row < data.size(); row++) {
-                for (size_t col = 0; col < col_typs.size()-1; ++col) {
-                        if(col_typs[col] != CATEGORICAL)
-                                continue;
-
-                        // for (size_t cate_index)
-                }
-        }
 }
 
-void read_libsvm(const string & filename, MyMat & data, vector<int> & labels, const string & label_min) {
+void read_libsvm(const string & filename, MyMat & data, vector<int> & labels, const feature_transform & transform) {
         cout << "begin " << filename << endl;
 
         ifstream file;
@@ -382,32 +266,13 @@ void read_libsvm(const string & filename, MyMat & data, vector<int> & labels, co
         file.open(filename);
 
         for (string line; getline(file, line); ) {
-                stringstream sep(line);
-                string item;
-
+                int label;
                 data.push_back(FeatureVec());
                 data.back().reserve(feature_size);
 
-                getline(sep, item, ' ');
-                // labels.push_back(stoi(item));
-		if (item == label_min) {
-			labels.push_back(1);
-		} else {
-			labels.push_back(-1);
-		}
-
-		for (; getline(sep, item, ' '); ) {
-                        auto colon_pos = item.find(':');
-                        int index = stoi(item.substr(0, colon_pos));
-                        FeatureData value = stod(item.substr(colon_pos+1));
-
-                        while (static_cast<int>(data.back().size()) < index - 1) {
-                                data.back().push_back(0);
-                        }
-
-                        data.back().push_back(value);
+                transform.parse_libsvm_row(line, data.back(), label);
+                labels.push_back(label);
 
-                }
                 feature_size = std::max(data.back().size(), feature_size);
         }
 
@@ -438,64 +303,6 @@ void write_csv(const string & filename, const MyMat& data, const vector<int> & l
         cout << "finished writing processed csv to " << filename << " in " << t.elapsed() << endl;
 }
 
-void normalize(MyMat & data) {
-        size_t rows = data.size();
-        size_t cols = data[0].size();
-
-        FeatureVec mean(cols, 0);
-        FeatureVec stds(cols);
-        FeatureVec variance(cols, 0);
-
-        for (size_t i = 0; i < rows; i++) {
-                for (size_t j = 0; j < cols; j++) {
-                        mean[j] += data[i][j];
-                }
-        }
-
-        for (size_t j = 0; j < cols; j++) {
-                mean[j] /= (FeatureData) rows;
-        }
-
-        for (size_t i = 0; i < rows; i++) {
-                for (size_t j = 0; j < cols; j++) {
-                        variance[j] += pow(data[i][j] - mean[j], 2);
-                }
-        }
-
-        for (size_t j = 0; j < cols; j++) {
-                stds[j] = sqrt(variance[j] / (FeatureData) (rows - 1));
-        }
-
-        for (size_t i = 0; i < rows; i++) {
-                for (size_t j = 0; j < cols; j++) {
-                        data[i][j] = (data[i][j] - mean[j]) / stds[j];
-                }
-        }
-}
-
-void scale(MyMat & data) {
-        size_t rows = data.size();
-        size_t cols = data[0].size();
-        FeatureVec max = FeatureVec(cols,std::numeric_limits<FeatureData>::min());
-        FeatureVec min = FeatureVec(cols,std::numeric_limits<FeatureData>::max());
-
-        for (size_t i = 0; i < rows; i++) {
-                for (size_t j = 0; j < cols; j++) {
-                        if (data[i][j] > max[j]) {
-                                max[j] = data[i][j];
-                        } else if (data[i][j] < min[j]) {
-                                min[j] = data[i][j];
-                        }
-                }
-        }
-
-        for (size_t i = 0; i < rows; i++) {
-                for (size_t j = 0; j < cols; j++) {
-                        data[i][j] = (data[i][j] - min[j])/(max[j] - min[j]);
-                }
-        }
-}
-
 void split(const MyMat & data, const vector<int> labels, MyMat & min, MyMat & maj) {
         size_t rows = data.size();
         MyMat data_cpy(data);
@@ -20,6 +20,7 @@
 #include "svm/svm_solver.h"
 #include "svm/svm_solver_libsvm.h"
 #include "svm/svm_solver_thunder.h"
+#include "svm/svm_solver_dense.h"
 #include "svm/svm_convert.h"
 #include "svm/k_fold.h"
 #include "svm/k_fold_build.h"
@@ -41,6 +42,9 @@ void print_null(const char *s) {}
 // #define SVM_SOLVER svm_solver_libsvm
 // #define SVM_MODEL svm_model
 
+// #define SVM_SOLVER svm_solver_dense
+// #define SVM_MODEL dense_model
+
 void kfold_instance(PartitionConfig& partition_config, std::unique_ptr<k_fold>& kfold, results& results) {
         timer t;
         graph_access *G_min = kfold->getMinGraph();
@@ -70,6 +74,9 @@ void kfold_instance(PartitionConfig& partition_config, std::unique_ptr<k_fold>&
         instance.read_problem(*G_min, *G_maj);
 
         SVM_SOLVER solver(instance);
+        solver.set_parallelism(partition_config.sweep_candidates, partition_config.sweep_threads);
+        solver.set_racing(partition_config.race_fraction);
+        solver.set_early_exit(partition_config.early_exit);
 
 	svm_result<SVM_MODEL> result(instance);
 	bayesopt::BOptState state;
@@ -85,7 +92,8 @@ void kfold_instance(PartitionConfig& partition_config, std::unique_ptr<k_fold>&
 								  *kfold->getMajValData(),
 								  state,
 								  10,
-								  partition_config.seed);
+								  partition_config.seed,
+								  partition_config.bayes_batch);
 		break;
 	case FIX:
 		result = fix_refinement<SVM_MODEL>::train_fix(solver,
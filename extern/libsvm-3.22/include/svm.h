@@ -46,6 +46,17 @@ struct svm_parameter
 	int probability; /* do probability estimates */
 };
 
+/*
+ * optional source of squared distances ||x_i - x_j||^2 for the RBF kernel.
+ * x[i] of the problem then only holds its row like PRECOMPUTED: (int)x[i][0].value
+ * row() returns the distances of row i to all rows, either cached or written to buf[l]
+ */
+struct svm_sq_dist
+{
+	void *data;
+	const float *(*row)(void *data, int i, float *buf);
+};
+
 //
 // svm_model
 // 
@@ -72,6 +83,10 @@ struct svm_model
 };
 
 struct svm_model *svm_train(const struct svm_problem *prob, const struct svm_parameter *param);
+/* init_alpha[l] (one unsigned alpha per training instance) is used as the starting point of SMO */
+struct svm_model *svm_train_warm(const struct svm_problem *prob, const struct svm_parameter *param, const double *init_alpha);
+/* C_SVC with RBF kernel evaluated from sq_dist, the returned SV point to the row nodes of prob */
+struct svm_model *svm_train_dist(const struct svm_problem *prob, const struct svm_parameter *param, const double *init_alpha, const struct svm_sq_dist *sq_dist);
 void svm_cross_validation(const struct svm_problem *prob, const struct svm_parameter *param, int nr_fold, double *target);
 
 int svm_save_model(const char *model_file_name, const struct svm_model *model);
@@ -201,7 +201,8 @@ public:
 
 class Kernel: public QMatrix {
 public:
-	Kernel(int l, svm_node * const * x, const svm_parameter& param);
+	Kernel(int l, svm_node * const * x, const svm_parameter& param,
+	       const svm_sq_dist *sq_dist = NULL);
 	virtual ~Kernel();
 
 	static double k_function(const svm_node *x, const svm_node *y,
@@ -217,9 +218,21 @@ protected:
 
 	double (Kernel::*kernel_function)(int i, int j) const;
 
+	// RBF from cached squared distances, d is the distance row of some x[i]
+	const svm_sq_dist *sq_dist;
+	const float *dist_row(int i) const
+	{
+		return sq_dist->row(sq_dist->data,(int)(x[i][0].value),dist_buf);
+	}
+	double kernel_rbf_dist(const float *d, int j) const
+	{
+		return exp(-gamma*d[(int)(x[j][0].value)]);
+	}
+
 private:
 	const svm_node **x;
 	double *x_square;
+	float *dist_buf;
 
 	// svm_parameter
 	const int kernel_type;
@@ -248,10 +261,15 @@ private:
 	{
 		return x[i][(int)(x[j][0].value)].value;
 	}
+	double kernel_rbf_cached(int i, int j) const
+	{
+		return kernel_rbf_dist(dist_row(i),j);
+	}
 };
 
-Kernel::Kernel(int l, svm_node * const * x_, const svm_parameter& param)
-:kernel_type(param.kernel_type), degree(param.degree),
+Kernel::Kernel(int l, svm_node * const * x_, const svm_parameter& param,
+	       const svm_sq_dist *sq_dist_)
+:sq_dist(sq_dist_), kernel_type(param.kernel_type), degree(param.degree),
  gamma(param.gamma), coef0(param.coef0)
 {
 	switch(kernel_type)
@@ -274,8 +292,15 @@ Kernel::Kernel(int l, svm_node * const * x_, const svm_parameter& param)
 	}
 
 	clone(x,x_,l);
+	dist_buf = 0;
 
-	if(kernel_type == RBF)
+	if(kernel_type == RBF && sq_dist)
+	{
+		kernel_function = &Kernel::kernel_rbf_cached;
+		dist_buf = new float[l];
+		x_square = 0;
+	}
+	else if(kernel_type == RBF)
 	{
 		x_square = new double[l];
 		for(int i=0;i<l;i++)
@@ -289,6 +314,7 @@ Kernel::~Kernel()
 {
 	delete[] x;
 	delete[] x_square;
+	delete[] dist_buf;
 }
 
 double Kernel::dot(const svm_node *px, const svm_node *py)
@@ -1266,14 +1292,16 @@ double Solver_NU::calculate_rho()
 class SVC_Q: public Kernel
 { 
 public:
-	SVC_Q(const svm_problem& prob, const svm_parameter& param, const schar *y_)
-	:Kernel(prob.l, prob.x, param)
+	SVC_Q(const svm_problem& prob, const svm_parameter& param, const schar *y_,
+	      const svm_sq_dist *sq_dist_ = NULL)
+	:Kernel(prob.l, prob.x, param, sq_dist_)
 	{
 		clone(y,y_,prob.l);
 		cache = new Cache(prob.l,(long int)(param.cache_size*(1<<20)));
 		QD = new double[prob.l];
+		// the RBF diagonal is 1, do not fetch a distance row per node for it
 		for(int i=0;i<prob.l;i++)
-			QD[i] = (this->*kernel_function)(i,i);
+			QD[i] = sq_dist ? 1 : (this->*kernel_function)(i,i);
 	}
 	
 	Qfloat *get_Q(int i, int len) const
@@ -1282,8 +1310,18 @@ public:
 		int start, j;
 		if((start = cache->get_data(i,&data,len)) < len)
 		{
-			for(j=start;j<len;j++)
-				data[j] = (Qfloat)(y[i]*y[j]*(this->*kernel_function)(i,j));
+			if(sq_dist)
+			{
+				// fetch the distance row once instead of once per entry
+				const float *d = dist_row(i);
+				for(j=start;j<len;j++)
+					data[j] = (Qfloat)(y[i]*y[j]*kernel_rbf_dist(d,j));
+			}
+			else
+			{
+				for(j=start;j<len;j++)
+					data[j] = (Qfloat)(y[i]*y[j]*(this->*kernel_function)(i,j));
+			}
 		}
 		return data;
 	}
@@ -1437,9 +1475,33 @@ private:
 //
 // construct and solve various formulations
 //
+//
+// make a warm start point feasible: 0 <= alpha <= C and sum y*alpha = 0
+//
+static void feasible_init_alpha(
+	int l, const schar *y, const double *init_alpha,
+	double *alpha, double Cp, double Cn)
+{
+	double sum_p = 0, sum_n = 0;
+	int i;
+	for(i=0;i<l;i++)
+	{
+		double C = y[i] > 0 ? Cp : Cn;
+		alpha[i] = min(max(init_alpha[i],0.0),C);
+		if(y[i] > 0) sum_p += alpha[i]; else sum_n += alpha[i];
+	}
+
+	// scale down the larger side, this keeps all alphas inside their box
+	double scale_p = sum_p > sum_n ? sum_n/sum_p : 1;
+	double scale_n = sum_n > sum_p ? sum_p/sum_n : 1;
+	for(i=0;i<l;i++)
+		alpha[i] *= y[i] > 0 ? scale_p : scale_n;
+}
+
 static void solve_c_svc(
 	const svm_problem *prob, const svm_parameter* param,
-	double *alpha, Solver::SolutionInfo* si, double Cp, double Cn)
+	double *alpha, Solver::SolutionInfo* si, double Cp, double Cn,
+	const double *init_alpha, const svm_sq_dist *sq_dist)
 {
 	int l = prob->l;
 	double *minus_ones = new double[l];
@@ -1454,8 +1516,11 @@ static void solve_c_svc(
 		if(prob->y[i] > 0) y[i] = +1; else y[i] = -1;
 	}
 
+	if(init_alpha)
+		feasible_init_alpha(l,y,init_alpha,alpha,Cp,Cn);
+
 	Solver s;
-	s.Solve(l, SVC_Q(*prob,*param,y), minus_ones, y,
+	s.Solve(l, SVC_Q(*prob,*param,y,sq_dist), minus_ones, y,
 		alpha, Cp, Cn, param->eps, si, param->shrinking);
 
 	double sum_alpha=0;
@@ -1646,14 +1711,15 @@ struct decision_function
 
 static decision_function svm_train_one(
 	const svm_problem *prob, const svm_parameter *param,
-	double Cp, double Cn)
+	double Cp, double Cn, const double *init_alpha = NULL,
+	const svm_sq_dist *sq_dist = NULL)
 {
 	double *alpha = Malloc(double,prob->l);
 	Solver::SolutionInfo si;
 	switch(param->svm_type)
 	{
 		case C_SVC:
-			solve_c_svc(prob,param,alpha,&si,Cp,Cn);
+			solve_c_svc(prob,param,alpha,&si,Cp,Cn,init_alpha,sq_dist);
 			break;
 		case NU_SVC:
 			solve_nu_svc(prob,param,alpha,&si);
@@ -2091,6 +2157,20 @@ static void svm_group_classes(const svm_problem *prob, int *nr_class_ret, int **
 //
 svm_model *svm_train(const svm_problem *prob, const svm_parameter *param)
 {
+	return svm_train_warm(prob,param,NULL);
+}
+
+svm_model *svm_train_warm(const svm_problem *prob, const svm_parameter *param, const double *init_alpha)
+{
+	return svm_train_dist(prob,param,init_alpha,NULL);
+}
+
+svm_model *svm_train_dist(const svm_problem *prob, const svm_parameter *param, const double *init_alpha, const svm_sq_dist *sq_dist)
+{
+	// the distance source only covers the RBF kernel of a single binary C_SVC problem
+	if(param->svm_type != C_SVC || param->kernel_type != RBF)
+		sq_dist = NULL;
+
 	svm_model *model = Malloc(svm_model,1);
 	model->param = *param;
 	model->free_sv = 0;	// XXX
@@ -2214,7 +2294,20 @@ svm_model *svm_train(const svm_problem *prob, const svm_parameter *param)
 				if(param->probability)
 					svm_binary_svc_probability(&sub_prob,param,weighted_C[i],weighted_C[j],probA[p],probB[p]);
 
-				f[p] = svm_train_one(&sub_prob,param,weighted_C[i],weighted_C[j]);
+				// warm start is only meaningful for a single binary problem
+				double *sub_alpha = NULL;
+				if(init_alpha && param->svm_type == C_SVC && nr_class == 2)
+				{
+					sub_alpha = Malloc(double,sub_prob.l);
+					for(k=0;k<ci;k++)
+						sub_alpha[k] = init_alpha[perm[si+k]];
+					for(k=0;k<cj;k++)
+						sub_alpha[ci+k] = init_alpha[perm[sj+k]];
+				}
+
+				f[p] = svm_train_one(&sub_prob,param,weighted_C[i],weighted_C[j],sub_alpha,
+						     nr_class == 2 ? sq_dist : NULL);
+				free(sub_alpha);
 				for(k=0;k<ci;k++)
 					if(!nonzero[si+k] && fabs(f[p].alpha[k]) > 0)
 						nonzero[si+k] = true;
@@ -49,7 +49,14 @@ typedef unsigned int  PathID;
 typedef unsigned int  PartitionID;
 typedef unsigned int  NodeWeight;
 typedef double     EdgeWeight;
+// feature values are single precision unless built with KASVM_DOUBLE_FEATURES
+// (scons precision=double), sums over many of them use FeatureSum
+#ifdef KASVM_DOUBLE_FEATURES
 typedef double FeatureData;
+#else
+typedef float FeatureData;
+#endif
+typedef double FeatureSum;
 typedef std::vector<FeatureData> FeatureVec;
 typedef EdgeWeight  Gain;
 typedef int     Color;
@@ -155,4 +162,9 @@ typedef enum {
 	FIX
 } RefinementType;
 
+typedef enum {
+	APPROX_RFF,
+	APPROX_NYSTROEM
+} ApproximationType;
+
 #endif
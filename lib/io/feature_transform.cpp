@@ -0,0 +1,293 @@
+#include "feature_transform.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+static inline void trim(std::string & s) {
+        s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](int ch) {
+                                return !std::isspace(ch);
+                        }));
+        s.erase(std::find_if(s.rbegin(), s.rend(), [](int ch) {
+                                return !std::isspace(ch);
+                        }).base(), s.end());
+}
+
+static const char * method_name(feature_transform::METHOD method) {
+        switch (method) {
+        case feature_transform::LINEAR:
+                return "linear";
+        case feature_transform::GAUSS_NORM:
+                return "gauss";
+        default:
+                return "none";
+        }
+}
+
+feature_transform::feature_transform()
+        : method(NONE), libsvm(false), label_col(0), label_min("1") {
+}
+
+void feature_transform::detect_columns(const std::string & line, bool has_label) {
+        this->col_typs.clear();
+
+        std::stringstream sep(line);
+        for (std::string item; getline(sep, item, ','); ) {
+                try {
+                        std::stod(item);
+                        this->col_typs.push_back(NUMERICAL);
+                } catch (...) {
+                        this->col_typs.push_back(CATEGORICAL);
+                }
+        }
+        if (has_label) {
+                this->col_typs[this->label_col] = LABEL;
+        } else {
+                this->col_typs.insert(this->col_typs.begin() + this->label_col, LABEL);
+        }
+        this->col_categorical_value.assign(this->col_typs.size(), std::vector<std::string>());
+}
+
+void feature_transform::parse_csv_row(const std::string & line, FeatureVec & row, int & label, bool learn, bool has_label) {
+        row.clear();
+        label = -1;
+
+        std::stringstream sep(line);
+        size_t col = 0;
+        for (std::string item; getline(sep, item, ','); ) {
+                if (!has_label && col == static_cast<size_t>(this->label_col)) {
+                        col++;
+                }
+                if (col >= this->col_typs.size()) {
+                        break;
+                }
+
+                switch (this->col_typs[col]) {
+                case LABEL:
+                        label = (item == this->label_min) ? 1 : -1;
+                        break;
+
+                case NUMERICAL:
+                        trim(item);
+                        if (item == "?" || item == "na") {
+                                row.push_back(-1);
+                        } else {
+                                row.push_back(std::stod(item));
+                        }
+                        break;
+
+                case CATEGORICAL:
+                        {
+                                // convert categorical attributes to integers
+                                std::vector<std::string> & values = this->col_categorical_value[col];
+                                auto it = std::find(values.begin(), values.end(), item);
+                                int cat = it - values.begin();
+                                if (it == values.end() && learn) {
+                                        values.push_back(item);
+                                }
+                                row.push_back(cat);
+                                break;
+                        }
+                }
+                col++;
+        }
+}
+
+void feature_transform::parse_libsvm_row(const std::string & line, FeatureVec & row, int & label, bool has_label) const {
+        row.clear();
+        label = -1;
+
+        std::stringstream sep(line);
+        std::string item;
+
+        if (has_label) {
+                getline(sep, item, ' ');
+                label = (item == this->label_min) ? 1 : -1;
+        }
+
+        for (; getline(sep, item, ' '); ) {
+                auto colon_pos = item.find(':');
+                if (colon_pos == std::string::npos) {
+                        continue;
+                }
+                int index = std::stoi(item.substr(0, colon_pos));
+                FeatureData value = std::stod(item.substr(colon_pos + 1));
+
+                while (static_cast<int>(row.size()) < index - 1) {
+                        row.push_back(0);
+                }
+                row.push_back(value);
+        }
+}
+
+void feature_transform::fit(std::vector<FeatureVec> & data) {
+        size_t rows = data.size();
+        size_t cols = data[0].size();
+
+        this->shift.assign(cols, 0);
+        this->divisor.assign(cols, 1);
+
+        switch (this->method) {
+        case GAUSS_NORM:
+                {
+                        // summed up in wider precision, there can be millions of rows
+                        std::vector<FeatureSum> mean(cols, 0);
+                        std::vector<FeatureSum> variance(cols, 0);
+
+                        for (size_t i = 0; i < rows; i++) {
+                                for (size_t j = 0; j < cols; j++) {
+                                        mean[j] += data[i][j];
+                                }
+                        }
+
+                        for (size_t j = 0; j < cols; j++) {
+                                mean[j] /= (FeatureSum) rows;
+                                this->shift[j] = mean[j];
+                        }
+
+                        for (size_t i = 0; i < rows; i++) {
+                                for (size_t j = 0; j < cols; j++) {
+                                        variance[j] += pow(data[i][j] - mean[j], 2);
+                                }
+                        }
+
+                        for (size_t j = 0; j < cols; j++) {
+                                this->divisor[j] = sqrt(variance[j] / (FeatureSum) (rows - 1));
+                        }
+                        break;
+                }
+        case LINEAR:
+                {
+                        FeatureVec max(cols, std::numeric_limits<FeatureData>::lowest());
+                        FeatureVec min(cols, std::numeric_limits<FeatureData>::max());
+
+                        for (size_t i = 0; i < rows; i++) {
+                                for (size_t j = 0; j < cols; j++) {
+                                        max[j] = std::max(max[j], data[i][j]);
+                                        min[j] = std::min(min[j], data[i][j]);
+                                }
+                        }
+
+                        for (size_t j = 0; j < cols; j++) {
+                                this->shift[j] = min[j];
+                                this->divisor[j] = max[j] - min[j];
+                        }
+                        break;
+                }
+        case NONE:
+                return;
+        }
+
+        for (size_t i = 0; i < rows; i++) {
+                apply(data[i]);
+        }
+}
+
+void feature_transform::apply(FeatureVec & row) const {
+        if (this->shift.empty()) {
+                return;
+        }
+
+        // features the training data did not have are dropped
+        row.resize(this->shift.size(), 0);
+        if (this->method == NONE) {
+                return;
+        }
+        for (size_t j = 0; j < row.size(); j++) {
+                row[j] = (row[j] - this->shift[j]) / this->divisor[j];
+        }
+}
+
+void feature_transform::save(const std::string & filename) const {
+        std::ofstream file(filename);
+        file << std::setprecision(std::numeric_limits<FeatureData>::max_digits10);
+
+        file << "method " << method_name(this->method) << std::endl;
+        file << "format " << (this->libsvm ? "libsvm" : "csv") << std::endl;
+        file << "label_col " << this->label_col << std::endl;
+        file << "label_min " << this->label_min << std::endl;
+
+        file << "columns " << this->col_typs.size();
+        for (COL_TYP typ : this->col_typs) {
+                file << " " << (typ == LABEL ? 'L' : typ == NUMERICAL ? 'N' : 'C');
+        }
+        file << std::endl;
+
+        // one value per line, they may contain spaces
+        for (size_t col = 0; col < this->col_categorical_value.size(); col++) {
+                if (this->col_typs[col] != CATEGORICAL)
+                        continue;
+                file << "categorical " << col << " " << this->col_categorical_value[col].size() << std::endl;
+                for (const std::string & value : this->col_categorical_value[col]) {
+                        file << value << std::endl;
+                }
+        }
+
+        file << "features " << this->shift.size() << std::endl;
+        for (size_t j = 0; j < this->shift.size(); j++) {
+                file << this->shift[j] << " " << this->divisor[j] << std::endl;
+        }
+}
+
+bool feature_transform::load(const std::string & filename) {
+        std::ifstream file(filename);
+        if (!file) {
+                std::cerr << "Error opening file " << filename << std::endl;
+                return false;
+        }
+
+        for (std::string line; getline(file, line); ) {
+                std::stringstream ss(line);
+                std::string key;
+                ss >> key;
+
+                if (key == "method") {
+                        std::string name;
+                        ss >> name;
+                        this->method = name == "gauss" ? GAUSS_NORM : name == "linear" ? LINEAR : NONE;
+                } else if (key == "format") {
+                        std::string format;
+                        ss >> format;
+                        this->libsvm = format == "libsvm";
+                } else if (key == "label_col") {
+                        ss >> this->label_col;
+                } else if (key == "label_min") {
+                        getline(ss >> std::ws, this->label_min);
+                } else if (key == "columns") {
+                        size_t cols = 0;
+                        ss >> cols;
+                        this->col_typs.resize(cols);
+                        this->col_categorical_value.assign(cols, std::vector<std::string>());
+                        for (size_t col = 0; col < cols; col++) {
+                                char typ;
+                                ss >> typ;
+                                this->col_typs[col] = typ == 'L' ? LABEL : typ == 'N' ? NUMERICAL : CATEGORICAL;
+                        }
+                } else if (key == "categorical") {
+                        size_t col = 0;
+                        size_t count = 0;
+                        ss >> col >> count;
+                        if (col >= this->col_categorical_value.size()) {
+                                return false;
+                        }
+                        for (size_t i = 0; i < count && getline(file, line); i++) {
+                                this->col_categorical_value[col].push_back(line);
+                        }
+                } else if (key == "features") {
+                        size_t cols = 0;
+                        ss >> cols;
+                        this->shift.resize(cols);
+                        this->divisor.resize(cols);
+                        for (size_t j = 0; j < cols; j++) {
+                                file >> this->shift[j] >> this->divisor[j];
+                        }
+                }
+        }
+
+        return true;
+}
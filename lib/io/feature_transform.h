@@ -0,0 +1,56 @@
+#ifndef FEATURE_TRANSFORM_H
+#define FEATURE_TRANSFORM_H
+
+#include <string>
+#include <vector>
+
+#include "definitions.h"
+
+// Everything 'prepare' does to a raw csv/libsvm row before it ends up in the
+// feature files: column types, categorical codes and the normalization.
+// prepare writes it next to the feature files so kasvm-predict can apply the
+// exact same transformation to new data.
+class feature_transform {
+public:
+        enum METHOD {
+                NONE, LINEAR, GAUSS_NORM
+        };
+
+        enum COL_TYP {
+                LABEL, NUMERICAL, CATEGORICAL
+        };
+
+        feature_transform();
+
+        // csv: determines the column types from the first data row
+        void detect_columns(const std::string & line, bool has_label = true);
+
+        // parse one input row into its features, the label is 1 for the minority class and -1 otherwise.
+        // With learn set unknown categorical values get a new code, otherwise they map to an unused one.
+        // Without has_label the row is expected to lack the label column.
+        void parse_csv_row(const std::string & line, FeatureVec & row, int & label, bool learn, bool has_label = true);
+        void parse_libsvm_row(const std::string & line, FeatureVec & row, int & label, bool has_label = true) const;
+
+        // compute the normalization parameters (mean/std or min/max) on the data and apply them
+        void fit(std::vector<FeatureVec> & data);
+
+        void apply(FeatureVec & row) const;
+
+        void save(const std::string & filename) const;
+        bool load(const std::string & filename);
+
+        METHOD method;
+        bool libsvm;
+        int label_col;
+        std::string label_min;
+
+        // csv only
+        std::vector<COL_TYP> col_typs;
+        std::vector<std::vector<std::string>> col_categorical_value;
+
+        // x' = (x - shift) / divisor per feature
+        FeatureVec shift;
+        FeatureVec divisor;
+};
+
+#endif /* FEATURE_TRANSFORM_H */
@@ -38,8 +38,8 @@ void svm_io::readFeaturesLines(const std::string & filename, std::vector<Feature
 }
 
 
-void svm_io::readTestSplit(const std::string & filename, std::vector<svm_feature> & min_test_data,
-                           std::vector<svm_feature> & maj_test_data) {
+void svm_io::readTestSplit(const std::string & filename, svm_data & min_test_data,
+                           svm_data & maj_test_data) {
         std::string line;
 
         // open file for reading
@@ -80,7 +80,7 @@ void svm_io::readTestSplit(const std::string & filename, std::vector<svm_feature
 }
 
 svm_data svm_io::sample_from_graph(const graph_access & G, float amount) {
-        std::vector<std::vector<svm_node>> nodes;
+        svm_data nodes;
 
         forall_nodes(G, n) {
                 if (random_functions::next() > amount) {
@@ -13,8 +13,8 @@ class svm_io {
 public:
         static void readFeaturesLines(const std::string & filename, std::vector<FeatureVec> & data);
 
-        static void readTestSplit(const std::string & filename, std::vector<svm_feature> & min_test_data,
-                                  std::vector<svm_feature> & maj_test_data);
+        static void readTestSplit(const std::string & filename, svm_data & min_test_data,
+                                  svm_data & maj_test_data);
 
         template<typename T>
         static std::vector<T> take_sample(const std::vector<T> & data, float percentage);
@@ -1,10 +1,31 @@
 #include "low_diameter_clustering.h"
 
-#include <unordered_map>
+#include <atomic>
+#include <limits>
+#include <omp.h>
 #include <utility>
 #include <algorithm>
 #include "tools/random_functions.h"
 
+namespace {
+
+// A claim on a node packs the fractional shift of a center (quantized to 32 bit) and the
+// center id, the smallest claim wins so ties are broken by the center id. VISITED is
+// below and UNCLAIMED above every claim.
+const uint64_t UNCLAIMED = std::numeric_limits<uint64_t>::max();
+const uint64_t VISITED = 0;
+
+inline uint64_t claim_key(double fraction, NodeID center) {
+        uint64_t quantized = std::min(fraction * 4294967296.0, 4294967294.0);
+        return ((quantized << 32) | center) + 1;
+}
+
+inline NodeID claim_center(uint64_t key) {
+        return (NodeID) ((key - 1) & 0xffffffff);
+}
+
+}
+
 low_diameter_clustering::low_diameter_clustering() {
 }
 
@@ -18,86 +39,109 @@ void low_diameter_clustering::match(const PartitionConfig & config,
                                     CoarseMapping & coarse_mapping,
                                     NodeID & no_of_coarse_vertices,
                                     NodePermutationMap & permutation) {
-        permutation.resize(G.number_of_nodes());
+        const NodeID n = G.number_of_nodes();
+        permutation.resize(n);
 
         // first: values from the exponential distribution to vertices
 	// second: the fractional part of its shift value
-        std::vector<std::pair<double, double>> delta(G.number_of_nodes());
+        std::vector<std::pair<double, double>> delta(n);
 
         // double beta = std::log(G.number_of_nodes()) / config.diameter_upperbound;
         // double beta = config.diameter_upperbound;
 	double beta = config.beta;
 
-        for (NodeID i = 0; i < G.number_of_nodes(); ++i) {
+        for (NodeID i = 0; i < n; ++i) {
                 delta[i].first = random_functions::nextFromExp(beta);
                 delta[i].second = random_functions::next();
         }
 
-        // Decomp-min
-	std::vector<std::pair<EdgeWeight,NodeID>> C(G.number_of_nodes(), std::make_pair(std::numeric_limits<EdgeWeight>::max(),
-											std::numeric_limits<NodeID>::max()));
-	std::vector<NodeID> frontier;
+        // a node becomes a center in round floor(delta) if it is unvisited by then.
+        // The nodes are sorted by that round, the number of rounds grows with 1 / beta
+        // and a bucket per round would too
+        auto round_of = [&](NodeID v) { return (size_t) delta[v].first; };
+        std::vector<NodeID> by_round(n);
+        for (NodeID i = 0; i < n; ++i) {
+                by_round[i] = i;
+        }
+        std::sort(by_round.begin(), by_round.end(), [&](NodeID a, NodeID b) {
+                        return round_of(a) < round_of(b) || (round_of(a) == round_of(b) && a < b);
+                });
+
+        // Decomp-min, the frontier nodes of a round claim their unvisited neighbours in parallel
+        std::vector<std::atomic<uint64_t>> claim(n);
+        std::vector<NodeID> center(n);
+#pragma omp parallel for schedule(static)
+        for (NodeID i = 0; i < n; ++i) {
+                claim[i].store(UNCLAIMED, std::memory_order_relaxed);
+        }
+
+        std::vector<NodeID> frontier;
+        std::vector<std::vector<NodeID>> claimed(omp_get_max_threads());
         NodeID numVisited = 0;
-        int rounds = 0;
+        NodeID next_center = 0;
+        size_t rounds = 0;
+
+	while (numVisited < n) {
+                // nothing left to grow, the rounds until the next center would be idle
+                if (frontier.empty() && next_center < n) {
+                        rounds = std::max(rounds, round_of(by_round[next_center]));
+                }
 
-	while (numVisited < G.number_of_nodes()) {
                 // add new BFS centers
-		forall_nodes(G, v) {
-			// node is unvisited
-			// and should be added in the current round
-			if (C[v].first == std::numeric_limits<EdgeWeight>::max()
-			    && delta[v].first < rounds + 1) {
+                for (; next_center < n && round_of(by_round[next_center]) <= rounds; next_center++) {
+                        NodeID v = by_round[next_center];
+                        if (claim[v].load(std::memory_order_relaxed) == UNCLAIMED) {
+                                claim[v].store(VISITED, std::memory_order_relaxed);
+                                center[v] = v;
                                 frontier.push_back(v);
-				C[v].first = -1;
-				C[v].second = v;
                         }
-                } endfor
+                }
                 numVisited += frontier.size();
-		std::unordered_set<NodeID> next_frontier;
-		for (NodeID v : frontier) {
-			forall_out_edges (G, e, v) {
-                                NodeID w = G.getEdgeTarget(e);
-				// EdgeWeight dist = C[v].first + G.getEdgeWeight(e);
-				// if egde from frontier node to unvisited node
-				if (C[w].first != -1
-				    && C[w].first > delta[C[v].second].second) {
-				// and frontier node is the nearest of the possible canditats this round
-				    // && C[w].first > dist) {
-				    // 	C[w].first = dist;
-				        C[w].first = delta[C[v].second].second;
-					C[w].second = C[v].second;
-                                        next_frontier.insert(w);
-                                }
-				// else intercomponent edge
-				// ignored handled later by the framework
-                        } endfor
+
+#pragma omp parallel
+                {
+                        // the thread that claims an unclaimed node first adds it to the next frontier,
+                        // the claim array doubles as the dense visited map of the round
+                        std::vector<NodeID> & next_frontier = claimed[omp_get_thread_num()];
+                        next_frontier.clear();
+
+#pragma omp for schedule(dynamic, 256)
+                        for (size_t i = 0; i < frontier.size(); i++) {
+                                NodeID v = frontier[i];
+                                uint64_t key = claim_key(delta[center[v]].second, center[v]);
+                                forall_out_edges (G, e, v) {
+                                        NodeID w = G.getEdgeTarget(e);
+                                        uint64_t cur = claim[w].load(std::memory_order_relaxed);
+                                        // else visited or intercomponent edge,
+                                        // ignored handled later by the framework
+                                        while (key < cur) {
+                                                if (claim[w].compare_exchange_weak(cur, key, std::memory_order_relaxed)) {
+                                                        if (cur == UNCLAIMED) {
+                                                                next_frontier.push_back(w);
+                                                        }
+                                                        break;
+                                                }
+                                        }
+                                } endfor
+                        }
+                }
+
+                frontier.clear();
+                for (const std::vector<NodeID> & next_frontier : claimed) {
+                        frontier.insert(frontier.end(), next_frontier.begin(), next_frontier.end());
+                }
+
+                // the claims of this round are final
+#pragma omp parallel for schedule(static)
+                for (size_t i = 0; i < frontier.size(); i++) {
+                        NodeID w = frontier[i];
+                        center[w] = claim_center(claim[w].load(std::memory_order_relaxed));
+                        claim[w].store(VISITED, std::memory_order_relaxed);
                 }
-                for (NodeID w : next_frontier) {
-			C[w].first = -1;
-		}
-		frontier.clear();
-		frontier.reserve(next_frontier.size());
-		frontier.insert(frontier.end(), next_frontier.begin(), next_frontier.end());
 		rounds++;
         }
 
-        remap_cluster_ids(G, coarse_mapping, no_of_coarse_vertices, C);
-}
-
-void low_diameter_clustering::remap_cluster_ids(const graph_access & G,
-						CoarseMapping & coarse_mapping,
-						NodeID & no_of_coarse_vertices,
-						const std::vector<std::pair<EdgeWeight,NodeID>> & C) {
-        coarse_mapping.resize(G.number_of_nodes());
-        no_of_coarse_vertices = 0;
-        std::unordered_map<NodeID, NodeID> remap;
-        forall_nodes(G, node) {
-                NodeID cur_cluster = C[node].second;
-                if (remap.count(cur_cluster) == 0) {
-                        remap[cur_cluster] = no_of_coarse_vertices;
-			no_of_coarse_vertices += 1;
-		}
-
-                coarse_mapping[node] = remap[cur_cluster];
-        } endfor
+        // the cluster ids are the centers
+        coarse_mapping = std::move(center);
+        parallel_remap_cluster_ids(coarse_mapping, no_of_coarse_vertices);
 }
@@ -5,7 +5,6 @@
 #include "partition/coarsening/matching/matching.h"
 
 #include <vector>
-#include <unordered_set>
 
 class low_diameter_clustering : public matching {
 public:
@@ -18,12 +17,6 @@ public:
                    CoarseMapping & coarse_mapping,
                    NodeID & no_of_coarse_vertices,
                    NodePermutationMap & permutation);
-
-private:
-        void remap_cluster_ids(const graph_access & G,
-                               CoarseMapping & coarse_mapping,
-                               NodeID & no_of_coarse_vertices,
-			       const std::vector<std::pair<EdgeWeight,NodeID>> & C);
 };
 
 #endif /* LOW_DIAMETER_CLUSTERING_H */
@@ -21,6 +21,10 @@
  *****************************************************************************/
 
 
+#include <algorithm>
+#include <atomic>
+#include <omp.h>
+#include <random>
 #include <unordered_map>
 
 #include <sstream>
@@ -36,6 +40,51 @@
 
 #include "size_constraint_label_propagation.h"
 
+namespace {
+
+// below this many nodes a single thread is faster and the clustering stays reproducible
+const NodeID PARALLEL_LP_MIN_NODES = 65536;
+
+// an edge to a neighbouring cluster, allowed is false if combine forbids it.
+// The weights are truncated to PartitionID and summed like in the sequential sweep.
+struct cluster_rating {
+        PartitionID block;
+        PartitionID weight;
+        bool allowed;
+};
+
+}
+
+std::vector<label_propagation_run> label_propagation_stats::run_list;
+bool label_propagation_stats::in_level = false;
+
+void label_propagation_stats::begin_level(NodeID nodes) {
+        run_list.push_back({nodes, 0, 0});
+        in_level = true;
+}
+
+void label_propagation_stats::end_level() {
+        in_level = false;
+}
+
+void label_propagation_stats::record(const label_propagation_run & run) {
+        if (!in_level) {
+                run_list.push_back(run);
+                return;
+        }
+        run_list.back().iterations += run.iterations;
+        run_list.back().visited += run.visited;
+}
+
+const std::vector<label_propagation_run> & label_propagation_stats::runs() {
+        return run_list;
+}
+
+void label_propagation_stats::reset() {
+        run_list.clear();
+        in_level = false;
+}
+
 size_constraint_label_propagation::size_constraint_label_propagation() {
                 
 }
@@ -54,11 +103,13 @@ void size_constraint_label_propagation::match(const PartitionConfig & partition_
         coarse_mapping.resize(G.number_of_nodes());
         no_of_coarse_vertices = 0;
 
+        label_propagation_stats::begin_level(G.number_of_nodes());
         if ( partition_config.ensemble_clusterings ) {
                 ensemble_clusterings(partition_config, G, _matching, coarse_mapping, no_of_coarse_vertices, permutation);
         } else {
                 match_internal(partition_config, G, _matching, coarse_mapping, no_of_coarse_vertices, permutation);
         }
+        label_propagation_stats::end_level();
 }
 
 void size_constraint_label_propagation::match_internal(const PartitionConfig & partition_config, 
@@ -151,6 +202,11 @@ void size_constraint_label_propagation::label_propagation(const PartitionConfig
                                                          const NodeWeight & block_upperbound,
                                                          std::vector<NodeWeight> & cluster_id,  
                                                          NodeID & no_of_blocks) {
+        if( partition_config.parallel_lp && omp_get_max_threads() > 1 && G.number_of_nodes() >= PARALLEL_LP_MIN_NODES ) {
+                parallel_label_propagation( partition_config, G, block_upperbound, cluster_id, no_of_blocks);
+                return;
+        }
+
         // in this case the _matching paramter is not used 
         // coarse_mappng stores cluster id and the mapping (it is identical)
         std::vector<PartitionID> hash_map(G.number_of_nodes(),0);
@@ -168,10 +224,18 @@ void size_constraint_label_propagation::label_propagation(const PartitionConfig
         node_ordering n_ordering;
         n_ordering.order_nodes(partition_config, G, permutation);
 
+        // with lp_active_set a round only visits the nodes with a neighbour that changed its cluster
+        std::vector<bool> active(G.number_of_nodes(), true);
+        std::vector<bool> next_active(partition_config.lp_active_set ? G.number_of_nodes() : 0, false);
+        int iterations   = 0;
+        uint64_t visited = 0;
+
         for( int j = 0; j < partition_config.label_iterations; j++) {
                 unsigned int change_counter = 0;
                 forall_nodes(G, i) {
                         NodeID node = permutation[i];
+                        if( !active[node] ) continue;
+                        visited++;
                         //now move the node to the cluster that is most common in the neighborhood
 
                         forall_out_edges(G, e, node) {
@@ -205,14 +269,177 @@ void size_constraint_label_propagation::label_propagation(const PartitionConfig
 			cluster_sizes[max_block]         += G.getNodeWeight(node);
 			cluster_local_sizes[max_block]++;
 			change_counter                   += (cluster_id[node] != max_block);
+
+                        if( partition_config.lp_active_set && cluster_id[node] != max_block ) {
+                                forall_out_edges(G, e, node) {
+                                        next_active[G.getEdgeTarget(e)] = true;
+                                } endfor
+                        }
 			cluster_id[node]                  = max_block;
                 } endfor
+                iterations++;
+
+                if( partition_config.lp_active_set ) {
+                        active.swap(next_active);
+                        std::fill(next_active.begin(), next_active.end(), false);
+                }
+                if( change_counter == 0 && partition_config.lp_active_set ) break;
+                if( change_counter < partition_config.lp_stop_fraction * G.number_of_nodes() ) break;
         }
 
+        label_propagation_stats::record({G.number_of_nodes(), iterations, visited});
         remap_cluster_ids( partition_config, G, cluster_id, no_of_blocks);
 }
 
 
+void size_constraint_label_propagation::parallel_label_propagation(const PartitionConfig & partition_config, 
+                                                                  graph_access & G, 
+                                                                  const NodeWeight & block_upperbound,
+                                                                  std::vector<NodeID> & cluster_id,  
+                                                                  NodeID & no_of_blocks) {
+        const NodeID n = G.number_of_nodes();
+        std::vector<NodeID> permutation(n);
+        // labels and cluster sizes are shared by all threads
+        std::vector<std::atomic<NodeID>> labels(n);
+        std::vector<std::atomic<NodeWeight>> cluster_sizes(n);
+        std::vector<std::atomic<NodeWeight>> cluster_local_sizes(n);
+        cluster_id.resize(n);
+
+#pragma omp parallel for schedule(static)
+        for( NodeID node = 0; node < n; node++) {
+                labels[node].store(node, std::memory_order_relaxed);
+                cluster_sizes[node].store(G.getNodeWeight(node), std::memory_order_relaxed);
+                cluster_local_sizes[node].store(1, std::memory_order_relaxed);
+        }
+
+        node_ordering n_ordering;
+        n_ordering.order_nodes(partition_config, G, permutation);
+
+        // with lp_active_set a round only visits the nodes with a neighbour that changed its cluster
+        std::vector<std::atomic<char>> active(n);
+        std::vector<std::atomic<char>> next_active(partition_config.lp_active_set ? n : 0);
+#pragma omp parallel for schedule(static)
+        for( NodeID node = 0; node < n; node++) {
+                active[node].store(1, std::memory_order_relaxed);
+                if( partition_config.lp_active_set ) {
+                        next_active[node].store(0, std::memory_order_relaxed);
+                }
+        }
+
+        int iterations   = 0;
+        uint64_t visited = 0;
+
+        for( int j = 0; j < partition_config.label_iterations; j++) {
+                NodeID change_counter = 0;
+
+#pragma omp parallel reduction(+:change_counter, visited)
+                {
+                        // the neighbouring clusters of a node are summed after sorting,
+                        // an n-sized scratch array per thread would not fit for large graphs
+                        std::vector<cluster_rating> neighbours;
+                        std::vector<cluster_rating> sums;
+                        std::mt19937 rng((partition_config.seed * 1000003 + j) * 1009 + omp_get_thread_num());
+
+#pragma omp for schedule(dynamic, 1024)
+                        for( NodeID i = 0; i < n; i++) {
+                                NodeID node          = permutation[i];
+                                if( !active[node].load(std::memory_order_relaxed) ) continue;
+                                visited++;
+
+                                NodeWeight weight    = G.getNodeWeight(node);
+                                PartitionID my_block = labels[node].load(std::memory_order_relaxed);
+
+                                neighbours.clear();
+                                forall_out_edges(G, e, node) {
+                                        NodeID target = G.getEdgeTarget(e);
+                                        bool allowed  = !partition_config.combine || G.getSecondPartitionIndex(node) == G.getSecondPartitionIndex(target);
+                                        neighbours.push_back({labels[target].load(std::memory_order_relaxed), (PartitionID) G.getEdgeWeight(e), allowed});
+                                } endfor
+
+                                sums.assign(neighbours.begin(), neighbours.end());
+                                std::sort(sums.begin(), sums.end(), [](const cluster_rating & a, const cluster_rating & b) {
+                                        return a.block < b.block;
+                                });
+                                size_t distinct = 0;
+                                for( size_t k = 0; k < sums.size(); k++) {
+                                        if( distinct > 0 && sums[distinct - 1].block == sums[k].block ) {
+                                                sums[distinct - 1].weight += sums[k].weight;
+                                        } else {
+                                                sums[distinct++] = sums[k];
+                                        }
+                                }
+                                sums.resize(distinct);
+
+                                // as in the sequential sweep the clusters are rated in edge order and
+                                // the sum of a cluster only counts at its first edge
+                                PartitionID max_block = my_block;
+                                PartitionID max_value = 0;
+                                for( const cluster_rating & cur : neighbours) {
+                                        auto sum = std::lower_bound(sums.begin(), sums.end(), cur.block, [](const cluster_rating & a, PartitionID block) {
+                                                return a.block < block;
+                                        });
+                                        PartitionID cur_value = sum->weight;
+                                        if((cur_value > max_value || (cur_value == max_value && (rng() & 1)))
+                                           && cur.allowed
+                                           && (cur.block == my_block
+                                               || (cluster_local_sizes[cur.block].load(std::memory_order_relaxed) + 1 < partition_config.cluster_upperbound
+                                                   && cluster_sizes[cur.block].load(std::memory_order_relaxed) + weight < block_upperbound)))
+                                        {
+                                                max_value = cur_value;
+                                                max_block = cur.block;
+                                        }
+                                        sum->weight = 0;
+                                }
+
+                                if( max_block == my_block ) {
+                                        continue;
+                                }
+
+                                // other threads may have filled the cluster since it was rated,
+                                // the space is reserved first and given back if a bound is exceeded
+                                if( cluster_sizes[max_block].fetch_add(weight) + weight >= block_upperbound ) {
+                                        cluster_sizes[max_block].fetch_sub(weight);
+                                        continue;
+                                }
+                                if( cluster_local_sizes[max_block].fetch_add(1) + 1 >= partition_config.cluster_upperbound ) {
+                                        cluster_local_sizes[max_block].fetch_sub(1);
+                                        cluster_sizes[max_block].fetch_sub(weight);
+                                        continue;
+                                }
+                                cluster_sizes[my_block].fetch_sub(weight);
+                                cluster_local_sizes[my_block].fetch_sub(1);
+                                labels[node].store(max_block, std::memory_order_relaxed);
+                                change_counter++;
+
+                                if( partition_config.lp_active_set ) {
+                                        forall_out_edges(G, e, node) {
+                                                next_active[G.getEdgeTarget(e)].store(1, std::memory_order_relaxed);
+                                        } endfor
+                                }
+                        }
+                }
+                iterations++;
+
+                if( partition_config.lp_active_set ) {
+                        active.swap(next_active);
+#pragma omp parallel for schedule(static)
+                        for( NodeID node = 0; node < n; node++) {
+                                next_active[node].store(0, std::memory_order_relaxed);
+                        }
+                }
+                if( change_counter == 0 && partition_config.lp_active_set ) break;
+                if( change_counter < partition_config.lp_stop_fraction * n ) break;
+        }
+
+        label_propagation_stats::record({n, iterations, visited});
+
+#pragma omp parallel for schedule(static)
+        for( NodeID node = 0; node < n; node++) {
+                cluster_id[node] = labels[node].load(std::memory_order_relaxed);
+        }
+
+        parallel_remap_cluster_ids( cluster_id, no_of_blocks);
+}
 
 void size_constraint_label_propagation::create_coarsemapping(const PartitionConfig & partition_config, 
                                                              graph_access & G,
@@ -249,7 +476,3 @@ void size_constraint_label_propagation::remap_cluster_ids(const PartitionConfig
 
         no_of_coarse_vertices = cur_no_clusters;
 }
-
-
-
-
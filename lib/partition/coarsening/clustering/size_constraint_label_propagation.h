@@ -58,6 +58,29 @@ typedef std::unordered_map<const ensemble_pair,
                                 hash_ensemble_pair, 
                                 compare_ensemble_pair> hash_ensemble;
 
+// rounds and visited nodes of the label propagation runs of one coarsening level,
+// summed over the clusterings of an ensemble
+struct label_propagation_run {
+        NodeID nodes;
+        int iterations;
+        uint64_t visited;
+};
+
+class label_propagation_stats {
+        public:
+                // runs recorded until end_level are added to this level,
+                // a run outside of a level gets an entry of its own
+                static void begin_level(NodeID nodes);
+                static void end_level();
+                static void record(const label_propagation_run & run);
+                static const std::vector<label_propagation_run> & runs();
+                static void reset();
+
+        protected:
+                static std::vector<label_propagation_run> run_list;
+                static bool in_level;
+};
+
 
 class size_constraint_label_propagation : public matching {
         public:
@@ -114,6 +137,13 @@ class size_constraint_label_propagation : public matching {
                                 std::vector<NodeWeight> & cluster_id,
                                 NodeID & number_of_blocks ); 
 
+                // multithreaded label_propagation, used for large graphs
+                void parallel_label_propagation(const PartitionConfig & partition_config, 
+                                graph_access & G,
+                                const NodeWeight & block_upperbound,
+                                std::vector<NodeID> & cluster_id, // output paramter
+                                NodeID & number_of_blocks); // output parameter
+
 };
 
 
@@ -20,10 +20,11 @@
  * this program.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 
+#include <algorithm>
+#include <atomic>
+
 #include "contraction.h"
-#include "partition/uncoarsening/refinement/quotient_graph_refinement/complete_boundary.h"
 #include "tools/macros_assertions.h"
-#include "tools/timer.h"
 
 contraction::contraction() {
 
@@ -66,6 +67,9 @@ void contraction::contract(const PartitionConfig & partition_config,
 
         NodeID cur_no_vertices = 0;
 
+        // buffer for the feature vec of a matched pair
+        FeatureVec new_feature_vec;
+
         forall_nodes(G, n) {
                 NodeID node = permutation[n];
                 //we look only at the coarser nodes
@@ -96,10 +100,9 @@ void contraction::contract(const PartitionConfig & partition_config,
                         coarser.setNodeWeight(coarseNode, new_coarse_weight);
 
                         //update feature vector weighted
-                        FeatureVec v1 = G.getFeatureVec(node);
-                        FeatureVec v2 = G.getFeatureVec(matched_neighbor);
-
-                        FeatureVec new_feature_vec = combineFeatureVec(v1, node_weight, v2, neighbor_weight);
+                        combineFeatureVec(G.getFeatureVec(node), node_weight,
+                                          G.getFeatureVec(matched_neighbor), neighbor_weight,
+                                          new_feature_vec);
 
                         coarser.setFeatureVec(coarseNode, new_feature_vec);
 
@@ -133,94 +136,204 @@ void contraction::contract_clustering(const PartitionConfig & partition_config,
                 coarser.resizeSecondPartitionIndex(no_of_coarse_vertices);
         }
 
-        //save partition map -- important if the graph is allready partitioned
-        std::vector< int > partition_map(G.number_of_nodes());
-        int k = G.get_partition_count();
+        build_quotient_graph(G, coarser, coarse_mapping, no_of_coarse_vertices);
+
+        const NodeID n  = G.number_of_nodes();
+        const NodeID nc = no_of_coarse_vertices;
+        const size_t num_features = G.getFeatureVec(0).size();
+
+        // the nodes of every cluster in increasing order, so each centroid is summed
+        // up by one thread in the same order as a sequential sweep would
+        std::vector<NodeID> members_begin(nc + 1, 0);
+        std::vector<NodeID> members(n);
         forall_nodes(G, node) {
-                partition_map[node] = G.getPartitionIndex(node);
-                G.setPartitionIndex(node, coarse_mapping[node]);
+                members_begin[coarse_mapping[node] + 1]++;
+        } endfor
+        for (NodeID c = 0; c < nc; c++) {
+                members_begin[c + 1] += members_begin[c];
+        }
+        std::vector<NodeID> next_member(members_begin.begin(), members_begin.end() - 1);
+        forall_nodes(G, node) {
+                members[next_member[coarse_mapping[node]]++] = node;
         } endfor
 
-        G.set_partition_count(no_of_coarse_vertices);
+        // centroids in a flat matrix, summed up in wider precision as a coarse node can stand for many nodes
+        std::vector<FeatureSum> centroids((size_t) nc * num_features, 0);
+        std::vector<FeatureData> coarse_features((size_t) nc * num_features);
 
-        complete_boundary bnd(&G);
-        bnd.build();
-        bnd.getUnderlyingQuotientGraph(coarser);
+#pragma omp parallel for schedule(dynamic, 64)
+        for (NodeID c = 0; c < nc; c++) {
+                FeatureSum * centroid = &centroids[(size_t) c * num_features];
+                NodeWeight block_size = 0;
 
-        G.set_partition_count(k);
+                for (NodeID i = members_begin[c]; i < members_begin[c + 1]; i++) {
+                        NodeID node = members[i];
+                        addWeightedToVec(centroid, G.getFeatureVec(node).data(), num_features, G.getNodeWeight(node));
+                        block_size += G.getNodeWeight(node);
 
-        // variables for calculating the feature vec of the coarse nodes
-        std::vector<NodeWeight> block_size(no_of_coarse_vertices);
-        int num_features = G.getFeatureVec(0).size();
-        std::vector<FeatureVec> combined_feature_vecs(no_of_coarse_vertices, FeatureVec(num_features, 0));
+                        if(partition_config.combine) {
+                                coarser.setSecondPartitionIndex(c, G.getSecondPartitionIndex(node));
+                        }
+                }
+                divideVec(centroid, num_features, block_size);
 
-        forall_nodes(G, node) {
-                NodeID coarsed_node = coarse_mapping[node];
-		// line commented out to keep the cluster index of the clustering in the partition index
-                // G.setPartitionIndex(node, partition_map[node]);
-                coarser.setPartitionIndex(coarsed_node, G.getPartitionIndex(node));
+                FeatureData * features = &coarse_features[(size_t) c * num_features];
+                std::copy(centroid, centroid + num_features, features);
 
-                addWeightedToVec(combined_feature_vecs[coarsed_node],
-                                 G.getFeatureVec(node),
-                                 G.getNodeWeight(node));
-                block_size[coarsed_node] += G.getNodeWeight(node);
+                // the partition index of a coarse node is its cluster index
+                coarser.setPartitionIndex(c, c);
+                coarser.setFeatureVec(c, FeatureVec(features, features + num_features));
+        }
 
-                if(partition_config.combine) {
-                        coarser.setSecondPartitionIndex(coarse_mapping[node], G.getSecondPartitionIndex(node));
-                }
+        // edge weights based on the distance of the feature vecs, the quotient graph is
+        // symmetric with sorted adjacencies so each weight is computed once and mirrored
+#pragma omp parallel for schedule(dynamic, 64)
+        for (NodeID node = 0; node < nc; node++) {
+                const FeatureData * features = &coarse_features[(size_t) node * num_features];
+                forall_out_edges(coarser, e, node) {
+                        NodeID target = coarser.getEdgeTarget(e);
+                        if (target < node) continue;
+
+                        EdgeWeight newWeight = 1 / calcFeatureDist(features, &coarse_features[(size_t) target * num_features], num_features);
+                        coarser.setEdgeWeight(e, newWeight);
+
+                        EdgeID first = coarser.get_first_edge(target);
+                        EdgeID last  = coarser.get_first_invalid_edge(target);
+                        while (first < last) {
+                                EdgeID mid = first + (last - first) / 2;
+                                if (coarser.getEdgeTarget(mid) < node) {
+                                        first = mid + 1;
+                                } else {
+                                        last = mid;
+                                }
+                        }
+                        coarser.setEdgeWeight(first, newWeight);
+                } endfor
+        }
+}
 
-        } endfor
+void contraction::build_quotient_graph(graph_access & G,
+                                       graph_access & coarser,
+                                       const CoarseMapping & coarse_mapping,
+                                       const NodeID & no_of_coarse_vertices) const {
+        const NodeID n  = G.number_of_nodes();
+        const NodeID nc = no_of_coarse_vertices;
+
+        // a cut edge is stored at both of its clusters, G does not have to be symmetric
+        std::vector<std::atomic<EdgeID>> bucket_size(nc);
+        std::vector<std::atomic<NodeWeight>> block_weight(nc);
+#pragma omp parallel for schedule(static)
+        for (NodeID c = 0; c < nc; c++) {
+                bucket_size[c].store(0, std::memory_order_relaxed);
+                block_weight[c].store(0, std::memory_order_relaxed);
+        }
+
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID node = 0; node < n; node++) {
+                NodeID source = coarse_mapping[node];
+                block_weight[source].fetch_add(G.getNodeWeight(node), std::memory_order_relaxed);
+                forall_out_edges(G, e, node) {
+                        NodeID target = coarse_mapping[G.getEdgeTarget(e)];
+                        if (target != source) {
+                                bucket_size[source].fetch_add(1, std::memory_order_relaxed);
+                                bucket_size[target].fetch_add(1, std::memory_order_relaxed);
+                        }
+                } endfor
+        }
+
+        std::vector<EdgeID> bucket_begin(nc + 1, 0);
+        for (NodeID c = 0; c < nc; c++) {
+                bucket_begin[c + 1] = bucket_begin[c] + bucket_size[c].load(std::memory_order_relaxed);
+                bucket_size[c].store(bucket_begin[c], std::memory_order_relaxed);
+        }
+
+        // the cut edges grouped by their source cluster
+        std::vector<std::pair<NodeID, EdgeWeight>> cut_edges(bucket_begin[nc]);
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (NodeID node = 0; node < n; node++) {
+                NodeID source = coarse_mapping[node];
+                forall_out_edges(G, e, node) {
+                        NodeID target = coarse_mapping[G.getEdgeTarget(e)];
+                        if (target != source) {
+                                EdgeWeight weight = G.getEdgeWeight(e);
+                                cut_edges[bucket_size[source].fetch_add(1, std::memory_order_relaxed)] = std::make_pair(target, weight);
+                                cut_edges[bucket_size[target].fetch_add(1, std::memory_order_relaxed)] = std::make_pair(source, weight);
+                        }
+                } endfor
+        }
 
-        forall_nodes(coarser, node) {
-                divideVec(combined_feature_vecs[node], block_size[node]);
-                coarser.setFeatureVec(node, combined_feature_vecs[node]);
-        endfor }
+        // parallel edges between two clusters are merged at the front of the bucket
+        std::vector<EdgeID> degree(nc);
+#pragma omp parallel for schedule(dynamic, 64)
+        for (NodeID c = 0; c < nc; c++) {
+                auto begin = cut_edges.begin() + bucket_begin[c];
+                auto end   = cut_edges.begin() + bucket_begin[c + 1];
+                std::sort(begin, end, [](const std::pair<NodeID, EdgeWeight> & a, const std::pair<NodeID, EdgeWeight> & b) {
+                        return a.first < b.first;
+                });
+
+                EdgeID distinct = 0;
+                for (auto it = begin; it != end; ++it) {
+                        if (distinct > 0 && (begin + distinct - 1)->first == it->first) {
+                                (begin + distinct - 1)->second += it->second;
+                        } else {
+                                *(begin + distinct) = *it;
+                                distinct++;
+                        }
+                }
+                degree[c] = distinct;
+        }
 
-	timer t;
+        EdgeID no_of_coarse_edges = 0;
+        for (NodeID c = 0; c < nc; c++) {
+                no_of_coarse_edges += degree[c];
+        }
 
-	//calculate edge weights based on the distance of the feature vec
-	forall_nodes(coarser, node) {
-		forall_out_edges(coarser, e, node) {
-			NodeID target = coarser.getEdgeTarget(e);
-			EdgeWeight newWeight = 1 / calcFeatureDist(coarser.getFeatureVec(node), coarser.getFeatureVec(target));
-			coarser.setEdgeWeight(e, newWeight);
-		endfor }
-	endfor }
+        coarser.start_construction(nc, no_of_coarse_edges);
+        for (NodeID c = 0; c < nc; c++) {
+                NodeID coarse_node = coarser.new_node();
+                for (EdgeID i = 0; i < degree[c]; i++) {
+                        coarser.new_edge(coarse_node, cut_edges[bucket_begin[c] + i].first);
+                }
+        }
+        coarser.finish_construction();
 
-	std::cout << "calc new weights took " << t.elapsed() << std::endl;
+        // every edge was counted from both sides, like the cut of complete_boundary
+#pragma omp parallel for schedule(dynamic, 64)
+        for (NodeID c = 0; c < nc; c++) {
+                coarser.setNodeWeight(c, block_weight[c].load(std::memory_order_relaxed));
+                EdgeID first = coarser.get_first_edge(c);
+                for (EdgeID i = 0; i < degree[c]; i++) {
+                        coarser.setEdgeWeight(first + i, cut_edges[bucket_begin[c] + i].second / 2);
+                }
+        }
 }
 
-FeatureVec contraction::combineFeatureVec(const FeatureVec & vec1, NodeWeight weight1,
-                                          const FeatureVec & vec2, NodeWeight weight2) const {
+void contraction::combineFeatureVec(const FeatureVec & vec1, NodeWeight weight1,
+                                    const FeatureVec & vec2, NodeWeight weight2,
+                                    FeatureVec & combined) const {
         size_t features = vec1.size();
-        FeatureVec combined_features(features);
+        combined.resize(features);
 
         for (size_t i = 0; i < features; ++i) {
-                combined_features[i] = (weight1 * vec1[i] + weight2 * vec2[i])
-                        / ((float)(weight1 + weight2));
+                combined[i] = ((FeatureSum) weight1 * vec1[i] + (FeatureSum) weight2 * vec2[i])
+                        / ((FeatureSum)(weight1 + weight2));
         }
-
-        return combined_features;
 }
 
-void contraction::divideVec(FeatureVec & vec, NodeWeight weights) const {
-        size_t features = vec.size();
-
+void contraction::divideVec(FeatureSum * vec, size_t features, NodeWeight weights) const {
         for (size_t i = 0; i < features; ++i) {
-                vec[i] /= (float) weights;
+                vec[i] /= (FeatureSum) weights;
         }
 }
 
-void contraction::addWeightedToVec(FeatureVec & vec, const FeatureVec & vecToAdd, NodeWeight weight) const {
-        size_t features = vec.size();
-
+void contraction::addWeightedToVec(FeatureSum * vec, const FeatureData * vecToAdd, size_t features, NodeWeight weight) const {
         for (size_t i = 0; i < features; ++i) {
-                vec[i] += vecToAdd[i] * weight;
+                vec[i] += (FeatureSum) vecToAdd[i] * weight;
         }
 }
 
-EdgeWeight contraction::calcFeatureDist(const FeatureVec & vec1,  const FeatureVec & vec2) const {
-        size_t features = vec1.size();
+EdgeWeight contraction::calcFeatureDist(const FeatureData * vec1, const FeatureData * vec2, size_t features) const {
 	EdgeWeight dist = 0;
 
         for (size_t i = 0; i < features; ++i) {
@@ -51,6 +51,13 @@ class contraction {
                                          const NodeID & no_of_coarse_vertices,
                                          const NodePermutationMap & permutation) const;
 
+                // builds the quotient graph of the clustering coarse_mapping without touching
+                // the partition indices of G, edge weights are the cut weights between clusters
+                void build_quotient_graph(graph_access & G,
+                                          graph_access & coarser,
+                                          const CoarseMapping & coarse_mapping,
+                                          const NodeID & no_of_coarse_vertices) const;
+
         private:
                 // visits an edge in G (and auxillary graph) and updates/creates and edge in coarser graph
                 void visit_edge(graph_access & G,
@@ -61,14 +68,16 @@ class contraction {
                                 const std::vector<NodeID> & new_edge_targets) const;
 
 
-                FeatureVec combineFeatureVec(const FeatureVec & vec1, NodeWeight weight1,
-                                             const FeatureVec & vec2, NodeWeight weight2) const;
+                // writes the weighted mean of both vecs to combined, which can be reused between calls
+                void combineFeatureVec(const FeatureVec & vec1, NodeWeight weight1,
+                                       const FeatureVec & vec2, NodeWeight weight2,
+                                       FeatureVec & combined) const;
 
-                void divideVec(FeatureVec & vec, NodeWeight weights) const;
+                void divideVec(FeatureSum * vec, size_t features, NodeWeight weights) const;
 
-                void addWeightedToVec(FeatureVec & vec, const FeatureVec & vecToAdd, NodeWeight weight) const;
+                void addWeightedToVec(FeatureSum * vec, const FeatureData * vecToAdd, size_t features, NodeWeight weight) const;
 
-		EdgeWeight calcFeatureDist(const FeatureVec & vec1,  const FeatureVec & vec2) const;
+		EdgeWeight calcFeatureDist(const FeatureData * vec1, const FeatureData * vec2, size_t features) const;
 };
 
 inline void contraction::visit_edge(graph_access & G,
@@ -20,6 +20,9 @@
  * this program.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 
+#include <atomic>
+#include <omp.h>
+
 #include "matching.h"
 
 matching::matching() {
@@ -36,4 +39,55 @@ void matching::print_matching(FILE * out, Matching & edge_matching) {
         }        
 }
 
+void matching::parallel_remap_cluster_ids(std::vector<NodeID> & cluster_id, NodeID & no_of_clusters) {
+        const NodeID n = cluster_id.size();
+        std::vector<std::atomic<char>> used(n);
+        std::vector<NodeID> new_id(n);
+        std::vector<NodeID> offsets;
+
+#pragma omp parallel for schedule(static)
+        for( NodeID node = 0; node < n; node++) {
+                used[node].store(0, std::memory_order_relaxed);
+        }
+
+#pragma omp parallel for schedule(static)
+        for( NodeID node = 0; node < n; node++) {
+                used[cluster_id[node]].store(1, std::memory_order_relaxed);
+        }
+
+#pragma omp parallel
+        {
+                const int threads = omp_get_num_threads();
+                const int t       = omp_get_thread_num();
+                const NodeID begin = (uint64_t) n * t / threads;
+                const NodeID end   = (uint64_t) n * (t + 1) / threads;
+
+#pragma omp single
+                offsets.assign(threads + 1, 0);
 
+                NodeID count = 0;
+                for( NodeID c = begin; c < end; c++) {
+                        count += used[c].load(std::memory_order_relaxed);
+                }
+                offsets[t + 1] = count;
+
+#pragma omp barrier
+#pragma omp single
+                for( int i = 0; i < threads; i++) {
+                        offsets[i + 1] += offsets[i];
+                }
+
+                NodeID next = offsets[t];
+                for( NodeID c = begin; c < end; c++) {
+                        new_id[c] = next;
+                        next     += used[c].load(std::memory_order_relaxed);
+                }
+        }
+
+#pragma omp parallel for schedule(static)
+        for( NodeID node = 0; node < n; node++) {
+                cluster_id[node] = new_id[cluster_id[node]];
+        }
+
+        no_of_clusters = offsets.back();
+}
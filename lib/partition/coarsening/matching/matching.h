@@ -39,6 +39,12 @@ class matching {
                                    NodePermutationMap & permutation) = 0;
 
                 void print_matching(FILE * out, Matching & edge_matching);
+
+        protected:
+                // cluster ids are node ids, the ones in use get consecutive numbers in
+                // the order of their old ids (parallel prefix sum), cluster_id is rewritten
+                static void parallel_remap_cluster_ids(std::vector<NodeID> & cluster_id,
+                                                       NodeID & no_of_clusters);
 };
 
 #endif /* end of include guard: MATCHING_QL4RUO3D */
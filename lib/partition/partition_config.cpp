@@ -1,7 +1,11 @@
 #include "partition/partition_config.h"
 
+#include <algorithm>
 #include <omp.h>
 
+#include "svm/svm_distance_cache.h"
+#include "svm/svm_result.h"
+#include "svm/svm_result_cache.h"
 #include "tools/random_functions.h"
 
 void PartitionConfig::print() {
@@ -20,6 +24,9 @@ void PartitionConfig::print() {
 	std::cout << "cluster_upperbound: " << this->cluster_upperbound << std::endl;
 	std::cout << "upper_bound_partition: " << this->upper_bound_partition << std::endl;
 	std::cout << "label_iterations: " << this->label_iterations << std::endl;
+	std::cout << "parallel_lp: " << this->parallel_lp << std::endl;
+	std::cout << "lp_active_set: " << this->lp_active_set << std::endl;
+	std::cout << "lp_stop_fraction: " << this->lp_stop_fraction << std::endl;
 	std::cout << "node_ordering: " << this->node_ordering << std::endl;
 	std::cout << "diameter_upperbound: " << this->diameter_upperbound << std::endl;
 	std::cout << "beta: " << this->beta << std::endl;
@@ -30,6 +37,22 @@ void PartitionConfig::print() {
 	}
 	std::cout << "num_skip_ms: " << this->num_skip_ms << std::endl;
 	std::cout << "inherit_ud: " << this->inherit_ud << std::endl;
+	std::cout << "sweep_candidates: " << this->sweep_candidates << std::endl;
+	std::cout << "sweep_threads: " << this->sweep_threads << std::endl;
+	std::cout << "warm_start: " << this->warm_start << std::endl;
+	std::cout << "distance_cache_mb: " << this->distance_cache_mb << std::endl;
+	std::cout << "result_cache: " << this->result_cache << std::endl;
+	std::cout << "result_models: " << this->result_models << std::endl;
+	std::cout << "predict_latency: " << this->predict_latency << std::endl;
+	std::cout << "bayes_batch: " << this->bayes_batch << std::endl;
+	std::cout << "race_fraction: " << this->race_fraction << std::endl;
+	std::cout << "early_exit: " << this->early_exit << std::endl;
+	std::cout << "compact_budget: " << this->compact_budget << std::endl;
+	std::cout << "compact_max_loss: " << this->compact_max_loss << std::endl;
+	std::cout << "approx_threshold: " << this->approx_threshold << std::endl;
+	std::cout << "approx_type: " << (this->approx_type == APPROX_NYSTROEM ? "nystroem" : "rff") << std::endl;
+	std::cout << "approx_dim: " << this->approx_dim << std::endl;
+	std::cout << "approx_orthogonal: " << this->approx_orthogonal << std::endl;
 	std::cout << "timeout: " << this->timeout << std::endl;
 	std::cout << "cores: " << this->n_cores << std::endl;
 	std::cout << "seed: " << this->seed << std::endl;
@@ -40,4 +63,7 @@ void PartitionConfig::apply() {
 	if (this->n_cores > 0) {
 		omp_set_num_threads(this->n_cores);
 	}
+	svm_distance_cache::set_budget(std::max(0, this->distance_cache_mb));
+	svm_result_cache_stats::set_enabled(this->result_cache);
+	svm_result_limits::set_models_kept(std::max(0, this->result_models));
 }
@@ -126,6 +126,16 @@ struct PartitionConfig
 
         NodeWeight cluster_upperbound = std::numeric_limits<NodeWeight>::max()/2;
 
+        // run label propagation on all threads for large graphs, the clustering
+        // then depends on the thread schedule and is not reproducible
+        bool parallel_lp = false;
+
+        // revisit only the nodes with a neighbour that changed its cluster in the previous round
+        bool lp_active_set = false;
+
+        // stop label propagation once fewer than this fraction of the nodes changed their cluster in a round
+        double lp_stop_fraction = 0;
+
         //=======================================
         //============LOW DIAMETER===============
         //=======================================
@@ -174,6 +184,56 @@ struct PartitionConfig
 
 	int bayes_max_steps = 10;
 
+	// proposals of a bayesian optimization step that are trained concurrently (1 = sequential)
+	int bayes_batch = 1;
+
+	// number of parameter candidates trained concurrently in a sweep
+	int sweep_candidates = 1;
+
+	// threads per candidate (0 = divide the cores among the candidates)
+	int sweep_threads = 0;
+
+	// seed the solver of a refinement level with the alphas of the previous level
+	bool warm_start = true;
+
+	// memory for the squared distances shared by the candidates of a sweep (0 = off)
+	int distance_cache_mb = 512;
+
+	// reuse the summary of a (C, gamma) pair that was already trained on the same level
+	bool result_cache = true;
+
+	// candidates of a level that keep their models, the others only keep their scores (0 = all)
+	int result_models = 4;
+
+	// time single sample predictions of the best model on the test data
+	bool predict_latency = false;
+
+	// racing: fraction of the validation data every candidate of a sweep is scored on
+	// before only the promising ones are scored on all of it (0 = off)
+	double race_fraction = 0;
+
+	// stop scoring a candidate of a sweep once it can't come within 0.02 Gmean of the best one
+	bool early_exit = true;
+
+	// merge SVs of the best model until at most this many are left (0 = off)
+	int compact_budget = 0;
+
+	// merge SVs as long as the validation Gmean drops by at most this much (0 = off)
+	double compact_max_loss = 0;
+
+	// levels with at least this many rows are trained on an explicit feature map
+	// by a linear solver (0 = off, dense solver only)
+	int approx_threshold = 0;
+
+	// random Fourier features or Nystroem features at rows of the coarser level
+	ApproximationType approx_type = APPROX_RFF;
+
+	// number of random features / landmarks of the approximation
+	int approx_dim = 512;
+
+	// orthogonal random features instead of independent ones
+	bool approx_orthogonal = false;
+
         void LogDump(FILE *out) const {
         }
 
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cmath>
 #include <bayesopt/bayesopt.hpp>
 #include <bayesopt/parameters.hpp>
 #include <boost/numeric/ublas/vector.hpp>
@@ -21,6 +22,7 @@ bayes_refinement<T>::bayes_refinement(graph_hierarchy & min_hierarchy,
 	this->seed = conf.seed;
 	this->fix_num_vert_stop = conf.fix_num_vert_stop;
 	this->bayes_max_steps = conf.bayes_max_steps;
+	this->bayes_batch = conf.bayes_batch;
 }
 
 template<class T>
@@ -32,19 +34,21 @@ svm_result<T> bayes_refinement<T>::step(const svm_data & min_sample, const svm_d
 
         std::vector<NodeID> sv_min = this->result.best().SV_min;
         std::vector<NodeID> sv_maj = this->result.best().SV_maj;
-        this->uncoarse(sv_min, sv_maj);
+        this->uncoarse(sv_min, sv_maj,
+                       this->result.best().alpha_min,
+                       this->result.best().alpha_maj);
 
         std::cout << "current level nodes"
-                  << " min " << this->uncoarsed_data_min.size()
-                  << " maj " << this->uncoarsed_data_maj.size()
+                  << " min " << this->uncoarsed_data_min->size()
+                  << " maj " << this->uncoarsed_data_maj->size()
                   << std::endl;
 
         svm_instance instance;
         instance.read_problem(this->uncoarsed_data_min, this->uncoarsed_data_maj);
-	std::unique_ptr<svm_solver<T>> solver = svm_solver_factory::create<T>(instance);
+	std::unique_ptr<svm_solver<T>> solver = this->create_solver(instance);
 
-        // if (this->uncoarsed_data_min.size() + this->uncoarsed_data_maj.size() < this->num_skip_ms) {
-	size_t data_size = this->uncoarsed_data_min.size() + this->uncoarsed_data_maj.size();
+        // if (this->uncoarsed_data_min->size() + this->uncoarsed_data_maj->size() < this->num_skip_ms) {
+	size_t data_size = this->uncoarsed_data_min->size() + this->uncoarsed_data_maj->size();
 	size_t max_init_size = 2 * this->fix_num_vert_stop;
 	float clipped_size = std::min(std::max(data_size, max_init_size), (size_t) this->num_skip_ms);
 	float ratio = (clipped_size - max_init_size) / (this->num_skip_ms - max_init_size);
@@ -56,7 +60,7 @@ svm_result<T> bayes_refinement<T>::step(const svm_data & min_sample, const svm_d
 		this->opt_state = bayesopt::BOptState();
 	}
 	this->result = train_bayes(*solver, min_sample, maj_sample,
-				   this->opt_state, iterations, this->seed);
+				   this->opt_state, iterations, this->seed, this->bayes_batch);
 	return this->result;
 }
 
@@ -69,19 +73,76 @@ class SolverOptimization: public ContinuousModel
 public:
 	SolverOptimization(Parameters param, svm_solver<T> & solver,
 			   const svm_data & min_sample, const svm_data & maj_sample,
-			   std::vector<svm_summary<T>> & summaries)
+			   svm_result<T> & result, int batch_size)
 		: ContinuousModel(2, param),
 		  solver(solver),
 		  min_sample(min_sample),
 		  maj_sample(maj_sample),
-		  summaries(summaries) {
+		  result(result),
+		  batch_size(batch_size) {
 	}
 
 	double evaluateSample(const boost::numeric::ublas::vector<double> &query) {
 		svm_param p = std::make_pair(query[0], query[1]);
-		auto summary = solver.train_single(p, min_sample, maj_sample);
-		summaries.push_back(summary);
-		return summary.eval(solver.get_instance());
+		if (batch_size <= 1) {
+			auto summary = solver.train_single(p, min_sample, maj_sample);
+			result.add(summary);
+			return summary.eval(solver.get_instance());
+		}
+
+		// constant liar: the query is trained with the rest of its batch in flush(),
+		// until then the surrogate sees the best value so far
+		pending.push_back(p);
+		return lie;
+	}
+
+	// starts the lies at the best value of a restored optimization
+	void restore_lie(const BOptState & state) {
+		for (size_t i = 0; i < state.mY.size(); i++) {
+			lie = std::min(lie, state.mY[i]);
+		}
+	}
+
+	// trains the pending queries concurrently and replaces their lies in the surrogate
+	void flush() {
+		if (pending.empty()) {
+			return;
+		}
+
+		BOptState state;
+		saveOptimization(state);
+
+		// the model stores the queries in the unit cube, the lies are among the
+		// last rows (queries replaced by a random jump never got a row)
+		std::vector<svm_param> batch;
+		std::vector<size_t> rows;
+		size_t first = state.mX.size() > pending.size() ? state.mX.size() - pending.size() : 0;
+		for (size_t i = first; i < state.mX.size() && i < state.mY.size(); i++) {
+			boost::numeric::ublas::vector<double> x = remapPoint(state.mX[i]);
+			// the mapping back and forth may change the last digits
+			auto it = std::find_if(pending.begin(), pending.end(), [&](const svm_param & q) {
+					return std::fabs(q.first - x[0]) <= 1e-4 * (1 + std::fabs(x[0]))
+						&& std::fabs(q.second - x[1]) <= 1e-4 * (1 + std::fabs(x[1]));
+				});
+			if (it != pending.end()) {
+				batch.push_back(*it);
+				rows.push_back(i);
+				pending.erase(it);
+			}
+		}
+		pending.clear();
+
+		std::vector<svm_summary<T>> trained = solver.train_batch(batch, min_sample, maj_sample, batch_size);
+		for (size_t k = 0; k < trained.size(); k++) {
+			double y = trained[k].eval(solver.get_instance());
+			state.mY[rows[k]] = y;
+			lie = std::min(lie, y);
+		}
+		result.add(trained);
+
+		// the lies were equal, so they must not count as being stuck
+		state.mCounterStuck = 0;
+		restoreOptimization(state);
 	}
 
 	bool checkReachability(const boost::numeric::ublas::vector<double> &query) { 
@@ -91,7 +152,13 @@ public:
 	svm_solver<T> & solver;
 	const svm_data & min_sample;
 	const svm_data & maj_sample;
-	std::vector<svm_summary<T>> & summaries;
+	// only the best summaries keep their models, there is one per evaluation
+	svm_result<T> & result;
+
+	int batch_size;
+	std::vector<svm_param> pending;
+	// no Gmean at all
+	double lie = 1;
 };
 
 template<class T>
@@ -100,8 +167,9 @@ svm_result<T> bayes_refinement<T>::train_bayes(svm_solver<T> & solver,
 					       const svm_data & maj_sample,
 					       BOptState & state,
 					       int optimization_steps,
-					       long seed) {
-	std::vector<svm_summary<T>> summaries;
+					       long seed,
+					       int batch_size) {
+	svm_result<T> result(solver.get_instance());
 	
 	Parameters params;
 	params.n_iterations = 10;
@@ -110,8 +178,16 @@ svm_result<T> bayes_refinement<T>::train_bayes(svm_solver<T> & solver,
 	params.random_seed = seed;
 	params.verbose_level = -1;
 	params.noise = 0.03;
-	params.force_jump = 5;
-	SolverOptimization<T> optimizer(params, solver, min_sample, maj_sample, summaries);
+
+	// every run gets at least two rounds of proposals on real Gmeans, a larger
+	// batch would make all of its proposals against lies
+	size_t steps = state.mX.size() > 0 ? optimization_steps : params.n_iterations;
+	batch_size = std::max(1, std::min(batch_size, static_cast<int>(steps / 2)));
+
+	// the lies of a batch have equal values, so every lied step would count as
+	// being stuck and force a random jump every few proposals
+	params.force_jump = batch_size > 1 ? 0 : 5;
+	SolverOptimization<T> optimizer(params, solver, min_sample, maj_sample, result, batch_size);
 
 	boost::numeric::ublas::vector<double> bestPoint(2);
 	boost::numeric::ublas::vector<double> lowerBound(2);
@@ -128,22 +204,38 @@ svm_result<T> bayes_refinement<T>::train_bayes(svm_solver<T> & solver,
 	if (state.mX.size() > 0) {
 		// restore previous optimization
 		optimizer.restoreOptimization(state);
+		optimizer.restore_lie(state);
 		bestPoint = optimizer.getFinalResult();
 		// refinement optimization
 		optimizer.forceOptimization(bestPoint);
 		std::cout << optimization_steps << "\n";
 		for (int i = 0; i < optimization_steps; ++i) {
 			optimizer.stepOptimization();
+			if ((i + 1) % batch_size == 0) {
+				optimizer.flush();
+			}
 		}
+		optimizer.flush();
 		optimizer.getFinalResult();
-	} else {
+	} else if (batch_size <= 1) {
 		//Define bounds and optimize
 		optimizer.optimize(bestPoint);
+	} else {
+		// as optimize() but the proposals are trained in batches,
+		// the initial design is a single batch
+		optimizer.initializeOptimization();
+		optimizer.flush();
+		for (size_t i = 0; i < params.n_iterations; ++i) {
+			optimizer.stepOptimization();
+			if ((i + 1) % batch_size == 0) {
+				optimizer.flush();
+			}
+		}
+		optimizer.flush();
+		bestPoint = optimizer.getFinalResult();
 	}
 	optimizer.saveOptimization(state);
 
-	svm_result<T> result(summaries, solver.get_instance());
-
 	result.best().print();
 
 	return result;
@@ -152,3 +244,4 @@ svm_result<T> bayes_refinement<T>::train_bayes(svm_solver<T> & solver,
 
 template class bayes_refinement<svm_model>;
 template class bayes_refinement<SVC>;
+template class bayes_refinement<dense_model>;
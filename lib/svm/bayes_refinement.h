@@ -26,11 +26,13 @@ public:
 					 const svm_data & maj_sample,
 					 bayesopt::BOptState & state,
 					 int optimization_steps,
-					 long seed);
+					 long seed,
+					 int batch_size = 1);
 private:
 	long seed;
 	int fix_num_vert_stop;
 	int bayes_max_steps;
+	int bayes_batch;
 	bayesopt::BOptState opt_state;
 };
 
@@ -0,0 +1,449 @@
+#include <algorithm>
+#include <cmath>
+
+#include "svm/dense_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DENSE_KERNELS_X86
+#endif
+
+dense_matrix::dense_matrix() : rows(0), features(0), stride(0) {
+}
+
+dense_matrix::dense_matrix(size_t rows, size_t features)
+        : rows(0), features(features) {
+        this->stride = std::max<size_t>(ROW_ALIGN, (features + ROW_ALIGN - 1) / ROW_ALIGN * ROW_ALIGN);
+        this->values.reserve(rows * this->stride);
+        this->norms.reserve(rows);
+}
+
+float dense_matrix::fill_row(const svm_node * node, size_t features, size_t stride, float * out) {
+        std::fill(out, out + stride, 0.0f);
+        double norm = 0;
+        for (; node->index != -1; ++node) {
+                // features unknown to the matrix still count for the distance
+                norm += node->value * node->value;
+                if (static_cast<size_t>(node->index) <= features) {
+                        out[node->index - 1] = node->value;
+                }
+        }
+        return norm;
+}
+
+void dense_matrix::append_row(const float * values, float norm) {
+        this->values.insert(this->values.end(), values, values + this->stride);
+        this->norms.push_back(norm);
+        this->rows++;
+}
+
+dense_matrix dense_matrix::from_nodes(svm_node * const * nodes, size_t n) {
+        size_t features = 0;
+        for (size_t i = 0; i < n; i++) {
+                for (const svm_node * node = nodes[i]; node->index != -1; ++node) {
+                        features = std::max(features, static_cast<size_t>(node->index));
+                }
+        }
+
+        dense_matrix M(n, features);
+        M.values.resize(n * M.stride);
+        M.norms.resize(n);
+        M.rows = n;
+        for (size_t i = 0; i < n; i++) {
+                M.norms[i] = fill_row(nodes[i], features, M.stride, M.values.data() + i * M.stride);
+        }
+        return M;
+}
+
+void dense_matrix::append_data(const svm_data & data) {
+        size_t first = this->rows;
+        this->rows += data.size();
+        this->values.resize(this->rows * this->stride);
+        this->norms.resize(this->rows);
+
+#pragma omp parallel for schedule(static) if(data.size() > 4096)
+        for (size_t i = 0; i < data.size(); i++) {
+                float * row = this->values.data() + (first + i) * this->stride;
+                this->norms[first + i] = fill_row(data[i].data(), this->features, this->stride, row);
+        }
+}
+
+dense_matrix dense_matrix::from_data(const svm_data & data, size_t features) {
+        dense_matrix M(data.size(), features);
+        M.append_data(data);
+        return M;
+}
+
+dense_matrix_double::dense_matrix_double() : rows(0), features(0) {
+}
+
+dense_matrix_double::dense_matrix_double(size_t rows, size_t features)
+        : rows(0), features(features) {
+        this->values.reserve(rows * features);
+        this->norms.reserve(rows);
+}
+
+double dense_matrix_double::fill_row(const svm_node * node, size_t features, double * out) {
+        std::fill(out, out + features, 0.0);
+        double norm = 0;
+        for (; node->index != -1; ++node) {
+                norm += node->value * node->value;
+                if (static_cast<size_t>(node->index) <= features) {
+                        out[node->index - 1] = node->value;
+                }
+        }
+        return norm;
+}
+
+dense_matrix_double dense_matrix_double::from_nodes(svm_node * const * nodes, size_t n) {
+        size_t features = 0;
+        for (size_t i = 0; i < n; i++) {
+                for (const svm_node * node = nodes[i]; node->index != -1; ++node) {
+                        features = std::max(features, static_cast<size_t>(node->index));
+                }
+        }
+
+        dense_matrix_double M(n, features);
+        M.values.resize(n * features);
+        M.norms.resize(n);
+        M.rows = n;
+        for (size_t i = 0; i < n; i++) {
+                M.norms[i] = fill_row(nodes[i], features, M.values.data() + i * features);
+        }
+        return M;
+}
+
+void dense_matrix_double::append_data(const svm_data & data) {
+        size_t first = this->rows;
+        this->rows += data.size();
+        this->values.resize(this->rows * this->features);
+        this->norms.resize(this->rows);
+
+#pragma omp parallel for schedule(static) if(data.size() > 4096)
+        for (size_t i = 0; i < data.size(); i++) {
+                double * row = this->values.data() + (first + i) * this->features;
+                this->norms[first + i] = fill_row(data[i].data(), this->features, row);
+        }
+}
+
+static void rbf_row_scalar(const float * x, float x_norm,
+                           const dense_matrix & M, size_t begin, size_t end,
+                           float gamma, float * out) {
+        for (size_t j = begin; j < end; j++) {
+                const float * m = M.row(j);
+                float dot = 0;
+                for (size_t k = 0; k < M.features; k++) {
+                        dot += x[k] * m[k];
+                }
+                float dist = std::max(0.0f, x_norm + M.norms[j] - 2 * dot);
+                out[j] = std::exp(-gamma * dist);
+        }
+}
+
+#ifdef DENSE_KERNELS_X86
+
+// exp as in cephes expf: 2^n * p(r) with |r| <= ln(2) / 2, valid for x <= 0 here
+__attribute__((target("avx2,fma")))
+static inline __m256 exp_avx2(__m256 x) {
+        x = _mm256_max_ps(x, _mm256_set1_ps(-87.3f));
+
+        __m256 fx = _mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f));
+        fx = _mm256_floor_ps(fx);
+        x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(0.693359375f), x);
+        x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(-2.12194440e-4f), x);
+
+        __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+        y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+
+        __m256i n = _mm256_cvttps_epi32(fx);
+        n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+__attribute__((target("avx2,fma")))
+static void rbf_row_avx2(const float * x, float x_norm,
+                         const dense_matrix & M, size_t begin, size_t end,
+                         float gamma, float * out) {
+        for (size_t j = begin; j < end; j++) {
+                const float * m = M.row(j);
+                __m256 acc0 = _mm256_setzero_ps();
+                __m256 acc1 = _mm256_setzero_ps();
+                for (size_t k = 0; k < M.stride; k += 16) {
+                        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + k), _mm256_loadu_ps(m + k), acc0);
+                        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + k + 8), _mm256_loadu_ps(m + k + 8), acc1);
+                }
+                __m256 acc = _mm256_add_ps(acc0, acc1);
+                __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+                sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+                sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+                float dist = std::max(0.0f, x_norm + M.norms[j] - 2 * _mm_cvtss_f32(sum));
+                out[j] = -gamma * dist;
+        }
+
+        size_t j = begin;
+        for (; j + 8 <= end; j += 8) {
+                _mm256_storeu_ps(out + j, exp_avx2(_mm256_loadu_ps(out + j)));
+        }
+        for (; j < end; j++) {
+                out[j] = std::exp(out[j]);
+        }
+}
+
+// the unmasked AVX-512 intrinsics of gcc 12 pass a self-initialized
+// _mm512_undefined_ps() as merge source, which -Wall reports once inlined
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+__attribute__((target("avx512f")))
+static inline __m512 exp_avx512(__m512 x) {
+        x = _mm512_max_ps(x, _mm512_set1_ps(-87.3f));
+
+        __m512 fx = _mm512_fmadd_ps(x, _mm512_set1_ps(1.44269504088896341f), _mm512_set1_ps(0.5f));
+        fx = _mm512_roundscale_ps(fx, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(0.693359375f), x);
+        x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(-2.12194440e-4f), x);
+
+        __m512 y = _mm512_set1_ps(1.9875691500e-4f);
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.3981999507e-3f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(8.3334519073e-3f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(4.1665795894e-2f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.6666665459e-1f));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(5.0000001201e-1f));
+        y = _mm512_fmadd_ps(y, _mm512_mul_ps(x, x), _mm512_add_ps(x, _mm512_set1_ps(1.0f)));
+
+        __m512i n = _mm512_cvttps_epi32(fx);
+        n = _mm512_slli_epi32(_mm512_add_epi32(n, _mm512_set1_epi32(127)), 23);
+        return _mm512_mul_ps(y, _mm512_castsi512_ps(n));
+}
+
+__attribute__((target("avx512f")))
+static void rbf_row_avx512(const float * x, float x_norm,
+                           const dense_matrix & M, size_t begin, size_t end,
+                           float gamma, float * out) {
+        for (size_t j = begin; j < end; j++) {
+                const float * m = M.row(j);
+                __m512 acc = _mm512_setzero_ps();
+                for (size_t k = 0; k < M.stride; k += 16) {
+                        acc = _mm512_fmadd_ps(_mm512_loadu_ps(x + k), _mm512_loadu_ps(m + k), acc);
+                }
+                float dist = std::max(0.0f, x_norm + M.norms[j] - 2 * _mm512_reduce_add_ps(acc));
+                out[j] = -gamma * dist;
+        }
+
+        size_t j = begin;
+        for (; j + 16 <= end; j += 16) {
+                _mm512_storeu_ps(out + j, exp_avx512(_mm512_loadu_ps(out + j)));
+        }
+        if (j < end) {
+                __mmask16 mask = (__mmask16) ((1u << (end - j)) - 1);
+                __m512 v = _mm512_maskz_loadu_ps(mask, out + j);
+                _mm512_mask_storeu_ps(out + j, mask, exp_avx512(v));
+        }
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+typedef void (*rbf_row_function)(const float *, float, const dense_matrix &, size_t, size_t, float, float *);
+
+struct rbf_row_dispatch {
+        rbf_row_function function;
+        const char * isa;
+};
+
+static rbf_row_dispatch select_rbf_row() {
+#ifdef DENSE_KERNELS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+                return { &rbf_row_avx512, "avx512" };
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+                return { &rbf_row_avx2, "avx2" };
+        }
+#endif
+        return { &rbf_row_scalar, "scalar" };
+}
+
+static const rbf_row_dispatch & rbf_row_impl() {
+        static const rbf_row_dispatch dispatch = select_rbf_row();
+        return dispatch;
+}
+
+void dense_kernels::rbf_row(const float * x, float x_norm,
+                            const dense_matrix & M, size_t begin, size_t end,
+                            float gamma, float * out) {
+        rbf_row_impl().function(x, x_norm, M, begin, end, gamma, out);
+}
+
+void dense_kernels::rbf_decision(const dense_matrix & X, const dense_matrix & SV,
+                                 const double * coef, double rho, float gamma,
+                                 double * out) {
+        const size_t sample_block = 32;
+        const size_t sv_tile = std::max<size_t>(64, (32 << 10) / (SV.stride * sizeof(float)));
+
+#pragma omp parallel
+        {
+                std::vector<float> K(SV.rows);
+
+#pragma omp for schedule(dynamic, 1)
+                for (size_t b = 0; b < X.rows; b += sample_block) {
+                        size_t b_end = std::min(b + sample_block, X.rows);
+                        for (size_t i = b; i < b_end; i++) {
+                                out[i] = -rho;
+                        }
+
+                        for (size_t t = 0; t < SV.rows; t += sv_tile) {
+                                size_t t_end = std::min(t + sv_tile, SV.rows);
+                                for (size_t i = b; i < b_end; i++) {
+                                        rbf_row(X.row(i), X.norms[i], SV, t, t_end, gamma, K.data());
+                                        double sum = 0;
+                                        for (size_t j = t; j < t_end; j++) {
+                                                sum += coef[j] * K[j];
+                                        }
+                                        out[i] += sum;
+                                }
+                        }
+                }
+        }
+}
+
+void dense_kernels::rbf_decisions(const dense_matrix & X, const dense_matrix & SV,
+                                  const std::vector<std::vector<size_t>> & index,
+                                  const std::vector<std::vector<double>> & coef,
+                                  const std::vector<double> & rho, float gamma,
+                                  std::vector<std::vector<double>> & out) {
+        const size_t models = index.size();
+        out.assign(models, std::vector<double>(X.rows));
+
+#pragma omp parallel
+        {
+                std::vector<float> K(SV.rows);
+
+#pragma omp for schedule(dynamic, 32)
+                for (size_t i = 0; i < X.rows; i++) {
+                        rbf_row(X.row(i), X.norms[i], SV, 0, SV.rows, gamma, K.data());
+                        for (size_t m = 0; m < models; m++) {
+                                const size_t * idx = index[m].data();
+                                const double * c = coef[m].data();
+                                double sum = 0;
+                                for (size_t k = 0; k < index[m].size(); k++) {
+                                        sum += c[k] * K[idx[k]];
+                                }
+                                out[m][i] = sum - rho[m];
+                        }
+                }
+        }
+}
+
+// K[r * width + (j - begin)] = exp(-gamma * ||X_(i+r) - SV_j||^2) for the rows i <= i + r < i_end.
+// Four rows at a time share the loads of an SV row and keep independent sums.
+static void rbf_block_double(const dense_matrix_double & X, size_t i, size_t i_end,
+                             const dense_matrix_double & SV, size_t begin, size_t end,
+                             double gamma, double * K) {
+        const size_t F = SV.features;
+        const size_t width = end - begin;
+
+        for (size_t r = i; r < i_end; r += 4) {
+                size_t n = std::min<size_t>(4, i_end - r);
+                // missing rows repeat the last one, their values are not stored
+                const double * x0 = X.row(r);
+                const double * x1 = X.row(r + std::min<size_t>(1, n - 1));
+                const double * x2 = X.row(r + std::min<size_t>(2, n - 1));
+                const double * x3 = X.row(r + std::min<size_t>(3, n - 1));
+
+                for (size_t j = begin; j < end; j++) {
+                        const double * sv = SV.row(j);
+                        double d0 = 0, d1 = 0, d2 = 0, d3 = 0;
+                        for (size_t k = 0; k < F; k++) {
+                                d0 += x0[k] * sv[k];
+                                d1 += x1[k] * sv[k];
+                                d2 += x2[k] * sv[k];
+                                d3 += x3[k] * sv[k];
+                        }
+                        double dot[4] = { d0, d1, d2, d3 };
+                        for (size_t q = 0; q < n; q++) {
+                                double dist = std::max(0.0, X.norms[r + q] + SV.norms[j] - 2 * dot[q]);
+                                K[(r - i + q) * width + (j - begin)] = std::exp(-gamma * dist);
+                        }
+                }
+        }
+}
+
+void dense_kernels::rbf_decision(const dense_matrix_double & X, const dense_matrix_double & SV,
+                                 const double * coef, double rho, double gamma,
+                                 double * out) {
+        const size_t sample_block = 32;
+        const size_t sv_tile = std::max<size_t>(16, (64 << 10) / (std::max<size_t>(1, SV.features) * sizeof(double)));
+
+#pragma omp parallel
+        {
+                std::vector<double> K(sample_block * std::min(sv_tile, SV.rows));
+
+#pragma omp for schedule(dynamic, 1)
+                for (size_t b = 0; b < X.rows; b += sample_block) {
+                        size_t b_end = std::min(b + sample_block, X.rows);
+                        for (size_t i = b; i < b_end; i++) {
+                                out[i] = -rho;
+                        }
+
+                        for (size_t t = 0; t < SV.rows; t += sv_tile) {
+                                size_t t_end = std::min(t + sv_tile, SV.rows);
+                                size_t width = t_end - t;
+                                rbf_block_double(X, b, b_end, SV, t, t_end, gamma, K.data());
+                                for (size_t i = b; i < b_end; i++) {
+                                        const double * k = K.data() + (i - b) * width;
+                                        double sum = 0;
+                                        for (size_t j = 0; j < width; j++) {
+                                                sum += coef[t + j] * k[j];
+                                        }
+                                        out[i] += sum;
+                                }
+                        }
+                }
+        }
+}
+
+void dense_kernels::rbf_decisions(const dense_matrix_double & X, const dense_matrix_double & SV,
+                                  const std::vector<std::vector<size_t>> & index,
+                                  const std::vector<std::vector<double>> & coef,
+                                  const std::vector<double> & rho, double gamma,
+                                  std::vector<std::vector<double>> & out) {
+        const size_t models = index.size();
+        const size_t sample_block = 8;
+        out.assign(models, std::vector<double>(X.rows));
+
+#pragma omp parallel
+        {
+                std::vector<double> K(sample_block * SV.rows);
+
+#pragma omp for schedule(dynamic, 4)
+                for (size_t b = 0; b < X.rows; b += sample_block) {
+                        size_t b_end = std::min(b + sample_block, X.rows);
+                        rbf_block_double(X, b, b_end, SV, 0, SV.rows, gamma, K.data());
+                        for (size_t i = b; i < b_end; i++) {
+                                const double * k = K.data() + (i - b) * SV.rows;
+                                for (size_t m = 0; m < models; m++) {
+                                        const size_t * idx = index[m].data();
+                                        const double * c = coef[m].data();
+                                        double sum = 0;
+                                        for (size_t q = 0; q < index[m].size(); q++) {
+                                                sum += c[q] * k[idx[q]];
+                                        }
+                                        out[m][i] = sum - rho[m];
+                                }
+                        }
+                }
+        }
+}
+
+const char * dense_kernels::isa() {
+        return rbf_row_impl().isa;
+}
@@ -0,0 +1,100 @@
+#ifndef DENSE_KERNELS_H
+#define DENSE_KERNELS_H
+
+#include <vector>
+#include <svm.h>
+
+#include "svm_definitions.h"
+
+// row-major float matrix, every row is zero padded to a multiple of
+// ROW_ALIGN floats so the SIMD kernels need no tail handling
+class dense_matrix
+{
+public:
+        static constexpr size_t ROW_ALIGN = 16;
+
+        dense_matrix();
+        dense_matrix(size_t rows, size_t features);
+
+        static dense_matrix from_nodes(svm_node * const * nodes, size_t n);
+        static dense_matrix from_data(const svm_data & data, size_t features);
+
+        // copies a sparse row into out (stride floats) and returns its full squared norm
+        static float fill_row(const svm_node * node, size_t features, size_t stride, float * out);
+
+        void append_row(const float * values, float norm);
+        void append_data(const svm_data & data);
+
+        const float * row(size_t i) const { return this->values.data() + i * this->stride; }
+
+        size_t rows;
+        size_t features;
+        size_t stride;
+        std::vector<float> values;
+        std::vector<float> norms;
+};
+
+// row-major double matrix without padding, for the backends whose labels have to
+// agree with svm_predict (libsvm computes the kernel in double)
+class dense_matrix_double
+{
+public:
+        dense_matrix_double();
+        dense_matrix_double(size_t rows, size_t features);
+
+        static dense_matrix_double from_nodes(svm_node * const * nodes, size_t n);
+
+        // copies a sparse row into out (features doubles) and returns its full squared norm
+        static double fill_row(const svm_node * node, size_t features, double * out);
+
+        void append_data(const svm_data & data);
+
+        const double * row(size_t i) const { return this->values.data() + i * this->features; }
+
+        size_t rows;
+        size_t features;
+        std::vector<double> values;
+        // of the full rows, features beyond the matrix count as well
+        std::vector<double> norms;
+};
+
+class dense_kernels
+{
+public:
+        // out[j] = exp(-gamma * ||x - M_j||^2) for begin <= j < end
+        static void rbf_row(const float * x, float x_norm,
+                            const dense_matrix & M, size_t begin, size_t end,
+                            float gamma, float * out);
+
+        // out[i] = sum_j coef[j] * exp(-gamma * ||X_i - SV_j||^2) - rho
+        // samples are processed in parallel blocks against tiles of SVs that stay in cache
+        static void rbf_decision(const dense_matrix & X, const dense_matrix & SV,
+                                 const double * coef, double rho, float gamma,
+                                 double * out);
+
+        // the same for several models with the same gamma whose SVs are rows of SV,
+        // index[m] / coef[m] are the SV rows and coefficients of model m.
+        // Every kernel value is computed once and used by all models.
+        // out[m][i] = sum_k coef[m][k] * exp(-gamma * ||X_i - SV_index[m][k]||^2) - rho[m]
+        static void rbf_decisions(const dense_matrix & X, const dense_matrix & SV,
+                                  const std::vector<std::vector<size_t>> & index,
+                                  const std::vector<std::vector<double>> & coef,
+                                  const std::vector<double> & rho, float gamma,
+                                  std::vector<std::vector<double>> & out);
+
+        // the same two in double: blocks of samples against tiles of SVs with
+        // ||x||^2 + ||sv||^2 - 2 x^T sv and the norms of the matrices
+        static void rbf_decision(const dense_matrix_double & X, const dense_matrix_double & SV,
+                                 const double * coef, double rho, double gamma,
+                                 double * out);
+        static void rbf_decisions(const dense_matrix_double & X, const dense_matrix_double & SV,
+                                  const std::vector<std::vector<size_t>> & index,
+                                  const std::vector<std::vector<double>> & coef,
+                                  const std::vector<double> & rho, double gamma,
+                                  std::vector<std::vector<double>> & out);
+
+        // name of the instruction set picked at runtime
+        static const char * isa();
+};
+
+#endif /* DENSE_KERNELS_H */
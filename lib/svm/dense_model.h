@@ -0,0 +1,35 @@
+#ifndef DENSE_MODEL_H
+#define DENSE_MODEL_H
+
+#include <memory>
+#include <vector>
+
+#include "dense_kernels.h"
+#include "kernel_map.h"
+
+// binary RBF model of svm_solver_dense, label +1 is the minority class
+// decision(x) = sum_i coef[i] * exp(-gamma * ||x - SV_i||^2) - rho
+struct dense_model
+{
+        float gamma = 0;
+        double rho = 0;
+
+        dense_matrix SV;
+        std::vector<double> coef;      // y_i * alpha_i
+        std::vector<int> sv_indices;   // rows of the training instance, minority rows first
+
+        int nSV_min = 0;
+        int nSV_maj = 0;
+
+        // approximately trained models are scored as decision(x) = w^T s(x) - rho with
+        // w folded by the map (see kernel_map::fold), SV / coef still hold the rows
+        // with alpha > 0 (the kernel expansion of the weights on the mapped rows)
+        std::shared_ptr<const kernel_map> map;
+        std::vector<double> w;
+
+        // the SVs were merged by compact(), they are no rows of the instance
+        // (sv_indices keep the row of a partner, -1 for Nystroem landmarks)
+        bool compacted = false;
+};
+
+#endif /* DENSE_MODEL_H */
@@ -20,16 +20,18 @@ svm_result<T> fix_refinement<T>::step(const svm_data & min_sample, const svm_dat
 
         std::vector<NodeID> sv_min = this->result.best().SV_min;
         std::vector<NodeID> sv_maj = this->result.best().SV_maj;
-        this->uncoarse(sv_min, sv_maj);
+        this->uncoarse(sv_min, sv_maj,
+                       this->result.best().alpha_min,
+                       this->result.best().alpha_maj);
 
         std::cout << "current level nodes"
-                  << " min " << this->uncoarsed_data_min.size()
-                  << " maj " << this->uncoarsed_data_maj.size()
+                  << " min " << this->uncoarsed_data_min->size()
+                  << " maj " << this->uncoarsed_data_maj->size()
                   << std::endl;
 
         svm_instance instance;
         instance.read_problem(this->uncoarsed_data_min, this->uncoarsed_data_maj);
-	std::unique_ptr<svm_solver<T>> solver = svm_solver_factory::create<T>(instance);
+	std::unique_ptr<svm_solver<T>> solver = this->create_solver(instance);
 
 	svm_summary<T> summary = solver->train_single(this->param, min_sample, maj_sample);
 	svm_result<T> res(std::vector<svm_summary<T>> {summary}, instance);
@@ -51,3 +53,4 @@ svm_result<T> fix_refinement<T>::train_fix(svm_solver<T> & solver,
 
 template class fix_refinement<svm_model>;
 template class fix_refinement<SVC>;
+template class fix_refinement<dense_model>;
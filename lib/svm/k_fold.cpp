@@ -39,19 +39,19 @@ graph_access* k_fold::getMajGraph() {
         return &this->cur_maj_graph;
 }
 
-std::vector<std::vector<svm_node>>* k_fold::getMinValData() {
+svm_data* k_fold::getMinValData() {
         return &this->cur_min_val;
 }
 
-std::vector<std::vector<svm_node>>* k_fold::getMajValData() {
+svm_data* k_fold::getMajValData() {
         return &this->cur_maj_val;
 }
 
-std::vector<std::vector<svm_node>>* k_fold::getMinTestData() {
+svm_data* k_fold::getMinTestData() {
         return &this->cur_min_test;
 }
 
-std::vector<std::vector<svm_node>>* k_fold::getMajTestData() {
+svm_data* k_fold::getMajTestData() {
         return &this->cur_maj_test;
 }
 
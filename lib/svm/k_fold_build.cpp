@@ -50,8 +50,8 @@ void k_fold_build::next_intern(double & io_time) {
 
 void k_fold_build::calculate_kfold_class(const std::vector<FeatureVec> & features_full,
 					 graph_access & target_graph,
-					 std::vector<std::vector<svm_node>> & target_val,
-					 std::vector<std::vector<svm_node>> & target_test) {
+					 svm_data & target_val,
+					 svm_data & target_test) {
 	NodeID nodes          = features_full.size();
         NodeID test_size      = floor(nodes / this->iterations);
         NodeID test_start     = k_fold::cur_iteration * test_size;
@@ -101,15 +101,19 @@ void k_fold_build::calculate_kfold_class(const std::vector<FeatureVec> & feature
 			  features_full.begin() + val_start,
 			  features_full.begin() + val_end);
 
-        target_val.reserve(val_size);
+        std::vector<const FeatureVec*> selected;
+        selected.reserve(val_size);
         for (const FeatureVec & f : val_subset) {
 		// apply sampling
                 if (this->sample_percent < 1 &&
 		    random_functions::next() > this->sample_percent) {
 			continue;
 		}
-                target_val.push_back(svm_convert::feature_to_node(f));
+                selected.push_back(&f);
         }
+        target_val = svm_data::build(selected.size(),
+                                     [&](size_t i) { return svm_convert::node_count(*selected[i]); },
+                                     [&](size_t i, svm_node * out) { svm_convert::fill_nodes(*selected[i], out); });
 
 	// build test set
         std::vector<FeatureVec> test_subset = std::vector<FeatureVec>();
@@ -117,8 +121,5 @@ void k_fold_build::calculate_kfold_class(const std::vector<FeatureVec> & feature
 			   features_full.begin() + test_start,
 			   features_full.begin() + test_end);
 
-        target_test.reserve(test_size);
-        for (const FeatureVec & f : test_subset) {
-                target_test.push_back(svm_convert::feature_to_node(f));
-        }
+        target_test = svm_convert::features_to_nodes(test_subset);
 }
@@ -45,7 +45,7 @@ void k_fold_import::next_intern(double & io_time) {
 
 double k_fold_import::read_class(const std::string & filename,
 				 graph_access & target_graph,
-				 std::vector<std::vector<svm_node>> & target_val) {
+				 svm_data & target_val) {
 	double time = 0;
         timer t;
         std::cout << "reading " << filename << std::endl;
@@ -86,14 +86,18 @@ double k_fold_import::read_class(const std::string & filename,
 			  features_full.end() - val_size,
 			  features_full.end());
 
-        target_val.reserve(val_size);
+        std::vector<const FeatureVec*> selected;
+        selected.reserve(val_size);
         for (const FeatureVec & f : val_subset) {
 		// apply sampling
                 if (random_functions::next() > this->sample_percent) {
 			continue;
 		}
-                target_val.push_back(svm_convert::feature_to_node(f));
+                selected.push_back(&f);
         }
+        target_val = svm_data::build(selected.size(),
+                                     [&](size_t i) { return svm_convert::node_count(*selected[i]); },
+                                     [&](size_t i, svm_node * out) { svm_convert::fill_nodes(*selected[i], out); });
 
 	return time;
 }
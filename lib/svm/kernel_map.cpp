@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "svm/kernel_map.h"
+
+dense_matrix kernel_map::map_all(const dense_matrix & X) const {
+        dense_matrix Z(X.rows, dimension());
+        Z.rows = X.rows;
+        Z.values.assign(Z.rows * Z.stride, 0.0f);
+        Z.norms.resize(Z.rows);
+
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < X.rows; i++) {
+                float * z = Z.values.data() + i * Z.stride;
+                map(X.row(i), X.norms[i], z);
+
+                double norm = 0;
+                for (size_t k = 0; k < Z.features; k++) {
+                        norm += z[k] * z[k];
+                }
+                Z.norms[i] = norm;
+        }
+
+        return Z;
+}
+
+std::vector<double> kernel_map::fold(const std::vector<double> & w) const {
+        return w;
+}
+
+size_t kernel_map::score_dimension() const {
+        return dimension();
+}
+
+void kernel_map::score_features(const float * x, float x_norm, float * out) const {
+        map(x, x_norm, out);
+}
+
+const dense_matrix * kernel_map::kernel_centers() const {
+        return nullptr;
+}
+
+rff_map::rff_map(size_t features, size_t dimension, float gamma, uint64_t seed, bool orthogonal)
+        : features(features), W(dimension, features), b(dimension),
+          scale(std::sqrt(2.0f / dimension)) {
+        std::mt19937_64 rng(seed);
+        std::normal_distribution<double> normal(0.0, 1.0);
+        std::uniform_real_distribution<double> uniform(0.0, 2 * M_PI);
+
+        const double sigma = std::sqrt(2.0 * gamma);
+        std::vector<std::vector<double>> block;
+        std::vector<float> row(this->W.stride, 0.0f);
+
+        for (size_t j = 0; j < dimension; j++) {
+                std::vector<double> w(features);
+                for (double & v : w) {
+                        v = normal(rng);
+                }
+
+                if (orthogonal) {
+                        // a new block every features rows, inside a block Gram-Schmidt
+                        // against the previous rows, the length is that of another gaussian row
+                        if (block.size() == features) {
+                                block.clear();
+                        }
+                        for (const std::vector<double> & q : block) {
+                                double dot = 0;
+                                for (size_t k = 0; k < features; k++) {
+                                        dot += w[k] * q[k];
+                                }
+                                for (size_t k = 0; k < features; k++) {
+                                        w[k] -= dot * q[k];
+                                }
+                        }
+                        double norm = 0;
+                        for (double v : w) {
+                                norm += v * v;
+                        }
+                        norm = std::sqrt(norm);
+                        for (double & v : w) {
+                                v /= norm;
+                        }
+                        block.push_back(w);
+
+                        double length = 0;
+                        for (size_t k = 0; k < features; k++) {
+                                double g = normal(rng);
+                                length += g * g;
+                        }
+                        length = std::sqrt(length);
+                        for (double & v : w) {
+                                v *= length;
+                        }
+                }
+
+                double norm = 0;
+                for (size_t k = 0; k < features; k++) {
+                        row[k] = sigma * w[k];
+                        norm += row[k] * row[k];
+                }
+                this->W.append_row(row.data(), norm);
+                this->b[j] = uniform(rng);
+        }
+}
+
+size_t rff_map::dimension() const {
+        return this->W.rows;
+}
+
+void rff_map::map(const float * x, float x_norm, float * out) const {
+        for (size_t j = 0; j < this->W.rows; j++) {
+                const float * w = this->W.row(j);
+                float dot = 0;
+                for (size_t k = 0; k < this->features; k++) {
+                        dot += w[k] * x[k];
+                }
+                out[j] = this->scale * std::cos(dot + this->b[j]);
+        }
+}
+
+nystroem_map::nystroem_map(const dense_matrix & landmarks, float gamma)
+        : landmarks(landmarks), gamma(gamma) {
+        const size_t m = landmarks.rows;
+        std::vector<float> K(m * m);
+
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < m; i++) {
+                dense_kernels::rbf_row(landmarks.row(i), landmarks.norms[i], landmarks, 0, m, gamma, &K[i * m]);
+        }
+
+        // landmarks may (almost) coincide, a growing jitter on the diagonal keeps K_LL definite
+        for (double jitter = 1e-8; ; jitter *= 10) {
+                this->R.assign(m * m, 0.0);
+                bool definite = true;
+                for (size_t j = 0; j < m && definite; j++) {
+                        double d = K[j * m + j] + jitter;
+                        for (size_t k = 0; k < j; k++) {
+                                d -= this->R[j * m + k] * this->R[j * m + k];
+                        }
+                        if (d <= 0) {
+                                definite = false;
+                                break;
+                        }
+                        d = std::sqrt(d);
+                        this->R[j * m + j] = d;
+                        for (size_t i = j + 1; i < m; i++) {
+                                double v = K[i * m + j];
+                                for (size_t k = 0; k < j; k++) {
+                                        v -= this->R[i * m + k] * this->R[j * m + k];
+                                }
+                                this->R[i * m + j] = v / d;
+                        }
+                }
+                if (definite || jitter > 1) {
+                        break;
+                }
+        }
+}
+
+size_t nystroem_map::dimension() const {
+        return this->landmarks.rows;
+}
+
+void nystroem_map::map(const float * x, float x_norm, float * out) const {
+        const size_t m = this->landmarks.rows;
+        score_features(x, x_norm, out);
+
+        // forward substitution R z = k
+        for (size_t i = 0; i < m; i++) {
+                const double * r = &this->R[i * m];
+                double v = out[i];
+                for (size_t k = 0; k < i; k++) {
+                        v -= r[k] * out[k];
+                }
+                out[i] = v / r[i];
+        }
+}
+
+std::vector<double> nystroem_map::fold(const std::vector<double> & w) const {
+        const size_t m = this->landmarks.rows;
+        std::vector<double> beta(w);
+
+        // back substitution R^T beta = w
+        for (size_t i = m; i-- > 0; ) {
+                double v = beta[i];
+                for (size_t k = i + 1; k < m; k++) {
+                        v -= this->R[k * m + i] * beta[k];
+                }
+                beta[i] = v / this->R[i * m + i];
+        }
+        return beta;
+}
+
+void nystroem_map::score_features(const float * x, float x_norm, float * out) const {
+        dense_kernels::rbf_row(x, x_norm, this->landmarks, 0, this->landmarks.rows, this->gamma, out);
+}
+
+const dense_matrix * nystroem_map::kernel_centers() const {
+        return &this->landmarks;
+}
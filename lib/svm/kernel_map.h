@@ -0,0 +1,79 @@
+#ifndef KERNEL_MAP_H
+#define KERNEL_MAP_H
+
+#include <cstdint>
+#include <vector>
+
+#include "dense_kernels.h"
+
+// Explicit feature map z with z(x)^T z(y) ~ exp(-gamma * ||x - y||^2).
+// A linear model w^T z(x) on the mapped rows approximates a kernel SVM,
+// it is trained in time linear in the rows and predicts in O(dimension).
+class kernel_map
+{
+public:
+        virtual ~kernel_map() {}
+
+        virtual size_t dimension() const = 0;
+
+        // writes the dimension() values of z(x), x is a row of a dense_matrix with
+        // the features of the map and x_norm its squared norm
+        virtual void map(const float * x, float x_norm, float * out) const = 0;
+
+        // z of every row of X, computed in parallel
+        dense_matrix map_all(const dense_matrix & X) const;
+
+        // a model w trained on z is scored as fold(w)^T s(x) - rho with the
+        // score_dimension() values s(x) of score_features, by default s = z
+        virtual std::vector<double> fold(const std::vector<double> & w) const;
+        virtual size_t score_dimension() const;
+        virtual void score_features(const float * x, float x_norm, float * out) const;
+
+        // rows whose RBF kernel values to x are s(x), then fold(w) is an exact
+        // kernel expansion over them. nullptr if s is no such expansion (default)
+        virtual const dense_matrix * kernel_centers() const;
+};
+
+// random Fourier features z(x) = sqrt(2 / D) * cos(W x + b) with W_jk ~ N(0, 2 gamma)
+// and b_j ~ U[0, 2 pi). With orthogonal the rows of W are orthogonalized in blocks of
+// features rows and rescaled to the norms of gaussian rows (orthogonal random features),
+// which gives a lower variance of the kernel estimate for the same D.
+class rff_map : public kernel_map
+{
+public:
+        rff_map(size_t features, size_t dimension, float gamma, uint64_t seed, bool orthogonal);
+
+        size_t dimension() const override;
+        void map(const float * x, float x_norm, float * out) const override;
+
+private:
+        size_t features;
+        dense_matrix W;
+        std::vector<float> b;
+        float scale;
+};
+
+// Nystroem features z(x) = R^-1 k_L(x) for the kernel values k_L(x) to the
+// m landmarks and K_LL = R R^T, so z(x)^T z(y) = k_L(x)^T K_LL^-1 k_L(y).
+// Mapping costs O(m^2) per row, a trained model is folded into the kernel
+// expansion R^-T w over the landmarks and scored in O(m).
+class nystroem_map : public kernel_map
+{
+public:
+        nystroem_map(const dense_matrix & landmarks, float gamma);
+
+        size_t dimension() const override;
+        void map(const float * x, float x_norm, float * out) const override;
+
+        std::vector<double> fold(const std::vector<double> & w) const override;
+        void score_features(const float * x, float x_norm, float * out) const override;
+        const dense_matrix * kernel_centers() const override;
+
+private:
+        dense_matrix landmarks;
+        float gamma;
+        // lower triangle of the Cholesky factor of K_LL, row-major m x m
+        std::vector<double> R;
+};
+
+#endif /* KERNEL_MAP_H */
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "svm/svm_compaction.h"
+
+namespace {
+
+// partners considered for every SV
+const size_t NEIGHBOURS = 8;
+
+struct merge_candidate {
+        double loss;
+        size_t i;
+        size_t j;
+        double h;
+        double coef;
+};
+
+// a_i * k(x_i, z) + a_j * k(x_j, z) for z = h * x_i + (1 - h) * x_j with k = k(x_i, x_j)
+inline double merged_coef(double a_i, double a_j, double k, double h) {
+        return a_i * std::pow(k, (1 - h) * (1 - h)) + a_j * std::pow(k, h * h);
+}
+
+// golden section search for the h with the largest |coef|, for distant pairs
+// the function has a peak at each end so those are checked as well
+void best_merge(double a_i, double a_j, double k, double & h, double & coef) {
+        const double ratio = 0.6180339887498949;
+
+        double lo = 0, hi = 1;
+        double x1 = hi - ratio * (hi - lo);
+        double x2 = lo + ratio * (hi - lo);
+        double f1 = std::fabs(merged_coef(a_i, a_j, k, x1));
+        double f2 = std::fabs(merged_coef(a_i, a_j, k, x2));
+        for (int it = 0; it < 24; it++) {
+                if (f1 < f2) {
+                        lo = x1;
+                        x1 = x2;
+                        f1 = f2;
+                        x2 = lo + ratio * (hi - lo);
+                        f2 = std::fabs(merged_coef(a_i, a_j, k, x2));
+                } else {
+                        hi = x2;
+                        x2 = x1;
+                        f2 = f1;
+                        x1 = hi - ratio * (hi - lo);
+                        f1 = std::fabs(merged_coef(a_i, a_j, k, x1));
+                }
+        }
+
+        h = (lo + hi) / 2;
+        coef = merged_coef(a_i, a_j, k, h);
+        for (double end : { 0.0, 1.0 }) {
+                double c = merged_coef(a_i, a_j, k, end);
+                if (std::fabs(c) > std::fabs(coef)) {
+                        h = end;
+                        coef = c;
+                }
+        }
+}
+
+}
+
+double svm_compaction::merge(dense_matrix & SV, std::vector<double> & coef, std::vector<int> & index,
+                             float gamma, size_t budget) {
+        double total_loss = 0;
+
+        while (SV.rows > budget) {
+                const size_t n = SV.rows;
+                const size_t need = n - budget;
+
+                // best partner of every SV among its closest SVs of the same class
+                std::vector<merge_candidate> candidates(n);
+
+#pragma omp parallel
+                {
+                        std::vector<float> K(n);
+                        std::vector<size_t> partners;
+
+#pragma omp for schedule(dynamic, 16)
+                        for (size_t i = 0; i < n; i++) {
+                                candidates[i] = { std::numeric_limits<double>::infinity(), i, i, 0, 0 };
+
+                                dense_kernels::rbf_row(SV.row(i), SV.norms[i], SV, 0, n, gamma, K.data());
+
+                                partners.clear();
+                                for (size_t j = 0; j < n; j++) {
+                                        if (j != i && (coef[j] > 0) == (coef[i] > 0)) {
+                                                partners.push_back(j);
+                                        }
+                                }
+                                size_t m = std::min(NEIGHBOURS, partners.size());
+                                std::partial_sort(partners.begin(), partners.begin() + m, partners.end(),
+                                                  [&](size_t a, size_t b) { return K[a] > K[b]; });
+
+                                for (size_t p = 0; p < m; p++) {
+                                        size_t j = partners[p];
+                                        double a_i = coef[i];
+                                        double a_j = coef[j];
+                                        double h, c;
+                                        best_merge(a_i, a_j, K[j], h, c);
+
+                                        // ||a_i phi(x_i) + a_j phi(x_j) - c phi(z)||^2 for the optimal c
+                                        double loss = a_i * a_i + a_j * a_j + 2 * a_i * a_j * K[j] - c * c;
+                                        if (loss < candidates[i].loss) {
+                                                candidates[i] = { loss, i, j, h, c };
+                                        }
+                                }
+                        }
+                }
+
+                std::sort(candidates.begin(), candidates.end(),
+                          [](const merge_candidate & a, const merge_candidate & b) { return a.loss < b.loss; });
+
+                // disjoint pairs with the smallest loss, a quarter of the SVs per round at most
+                // so the partners of the next round are searched on the merged set
+                const size_t max_merges = std::min(need, std::max<size_t>(1, n / 4));
+                std::vector<bool> used(n, false);
+                std::vector<merge_candidate> merges;
+                for (const merge_candidate & cand : candidates) {
+                        if (merges.size() >= max_merges || std::isinf(cand.loss)) {
+                                break;
+                        }
+                        if (used[cand.i] || used[cand.j]) {
+                                continue;
+                        }
+                        used[cand.i] = true;
+                        used[cand.j] = true;
+                        merges.push_back(cand);
+                }
+
+                if (merges.empty()) {
+                        // every class is down to a single SV
+                        break;
+                }
+
+                dense_matrix merged(n - merges.size(), SV.features);
+                std::vector<double> new_coef;
+                std::vector<int> new_index;
+                new_coef.reserve(n - merges.size());
+                new_index.reserve(n - merges.size());
+
+                std::vector<float> z(SV.stride);
+                for (const merge_candidate & m : merges) {
+                        const float * x_i = SV.row(m.i);
+                        const float * x_j = SV.row(m.j);
+                        double norm = 0;
+                        for (size_t k = 0; k < SV.stride; k++) {
+                                z[k] = m.h * x_i[k] + (1 - m.h) * x_j[k];
+                                norm += z[k] * z[k];
+                        }
+                        merged.append_row(z.data(), norm);
+                        new_coef.push_back(m.coef);
+                        new_index.push_back(std::fabs(coef[m.i]) >= std::fabs(coef[m.j]) ? index[m.i] : index[m.j]);
+                        total_loss += m.loss;
+                }
+
+                for (size_t i = 0; i < n; i++) {
+                        if (!used[i]) {
+                                merged.append_row(SV.row(i), SV.norms[i]);
+                                new_coef.push_back(coef[i]);
+                                new_index.push_back(index[i]);
+                        }
+                }
+
+                SV = std::move(merged);
+                coef = std::move(new_coef);
+                index = std::move(new_index);
+        }
+
+        return total_loss;
+}
+
+size_t svm_compaction::group_by_class(dense_matrix & SV, std::vector<double> & coef, std::vector<int> & index) {
+        std::vector<size_t> order(SV.rows);
+        for (size_t i = 0; i < order.size(); i++) {
+                order[i] = i;
+        }
+        auto first_negative = std::stable_partition(order.begin(), order.end(),
+                                                    [&](size_t i) { return coef[i] > 0; });
+
+        dense_matrix grouped(SV.rows, SV.features);
+        std::vector<double> grouped_coef;
+        std::vector<int> grouped_index;
+        grouped_coef.reserve(SV.rows);
+        grouped_index.reserve(SV.rows);
+        for (size_t i : order) {
+                grouped.append_row(SV.row(i), SV.norms[i]);
+                grouped_coef.push_back(coef[i]);
+                grouped_index.push_back(index[i]);
+        }
+
+        SV = std::move(grouped);
+        coef = std::move(grouped_coef);
+        index = std::move(grouped_index);
+
+        return first_negative - order.begin();
+}
@@ -0,0 +1,26 @@
+#ifndef SVM_COMPACTION_H
+#define SVM_COMPACTION_H
+
+#include <vector>
+
+#include "dense_kernels.h"
+
+// Reduced-set compaction of a binary RBF model. Two SVs of the same class are
+// replaced by one vector z = h * x_i + (1 - h) * x_j with coefficient
+// a_i * k(x_i, z) + a_j * k(x_j, z), h is chosen to keep ||w - w'|| small.
+// Only the closest SVs of the same class are considered as partners.
+class svm_compaction
+{
+public:
+        // merges SVs until at most budget are left (coef = y * alpha).
+        // index holds the instance row of every SV, a merged SV keeps the one
+        // of the partner with the larger |coef|.
+        // Returns the sum of ||w - w'||^2 over all merges.
+        static double merge(dense_matrix & SV, std::vector<double> & coef, std::vector<int> & index,
+                            float gamma, size_t budget);
+
+        // reorders the SVs so the ones with positive coef come first, returns their number
+        static size_t group_by_class(dense_matrix & SV, std::vector<double> & coef, std::vector<int> & index);
+};
+
+#endif /* SVM_COMPACTION_H */
@@ -1,28 +1,45 @@
 #include "svm_convert.h"
+#include <cstring>
 #include <unordered_set>
 
 svm_feature svm_convert::feature_to_node(const FeatureVec & vec) {
-        std::vector<svm_node> nodes;
+        svm_feature nodes(node_count(vec));
+        fill_nodes(vec, nodes.data());
+        return nodes;
+}
+
+size_t svm_convert::node_count(const FeatureVec & vec) {
+        size_t count = 1; // end node
+        for (FeatureData value : vec) {
+                if (std::abs(value) >= EPS)
+                        count++;
+        }
+        return count;
+}
+
+void svm_convert::fill_nodes(const FeatureVec & vec, svm_node * out) {
         size_t features = vec.size();
 
         for (size_t i = 0; i < features; ++i) {
                 if (std::abs(vec[i]) < EPS) // skip zero valued features
                         continue;
-                svm_node n;
-                n.index = i+1;
-                n.value = vec[i];
-                nodes.push_back(n);
+                out->index = i+1;
+                out->value = vec[i];
+                ++out;
         }
 
-        svm_node n; // end node
-        n.index = -1;
-        n.value = 0;
-        nodes.push_back(n);
+        // end node
+        out->index = -1;
+        out->value = 0;
+}
 
-        return nodes;
+svm_data svm_convert::features_to_nodes(const std::vector<FeatureVec> & vecs) {
+        return svm_data::build(vecs.size(),
+                               [&](size_t i) { return node_count(vecs[i]); },
+                               [&](size_t i, svm_node * out) { fill_nodes(vecs[i], out); });
 }
 
-FeatureVec svm_convert::node_to_feature(const svm_feature & data) {
+FeatureVec svm_convert::node_to_feature(svm_row data) {
 	FeatureVec result;
 	size_t i = 0;
 	for (const svm_node & node : data) {
@@ -38,27 +55,29 @@ FeatureVec svm_convert::node_to_feature(const svm_feature & data) {
 }
 
 svm_data svm_convert::graph_to_nodes(const graph_access & G) {
-        std::vector<std::vector<svm_node>> nodes;
-
-        forall_nodes(G, n) {
-                nodes.push_back(svm_convert::feature_to_node(G.getFeatureVec(n)));
-        } endfor
-
-        return nodes;
+        return svm_data::build(G.number_of_nodes(),
+                               [&](size_t n) { return node_count(G.getFeatureVec(n)); },
+                               [&](size_t n, svm_node * out) { fill_nodes(G.getFeatureVec(n), out); });
 }
 
 svm_data svm_convert::graph_part_to_nodes(const graph_access & G, const std::vector<NodeID> & sv) {
-        svm_data nodes;
+        std::vector<NodeID> rows;
 
         std::unordered_set<NodeID> sv_set{sv.begin(), sv.end()};
 
         forall_nodes(G, node) {
                 if (sv_set.find(node) != sv_set.end()) {
-                        nodes.push_back(svm_convert::feature_to_node(G.getFeatureVec(node)));
+                        rows.push_back(node);
                 }
         } endfor
 
-        return nodes;
+        return graph_rows_to_nodes(G, rows);
+}
+
+svm_data svm_convert::graph_rows_to_nodes(const graph_access & G, const std::vector<NodeID> & rows) {
+        return svm_data::build(rows.size(),
+                               [&](size_t i) { return node_count(G.getFeatureVec(rows[i])); },
+                               [&](size_t i, svm_node * out) { fill_nodes(G.getFeatureVec(rows[i]), out); });
 }
 
 
@@ -75,3 +94,28 @@ DataSet::node2d svm_convert::svmdata_to_dataset(const svm_data & data) {
 	}
 	return result;
 }
+
+uint64_t svm_convert::fingerprint(const svm_data & data, uint64_t seed) {
+        const uint64_t prime = 1099511628211ull;
+        uint64_t hash = 14695981039346656037ull ^ seed;
+
+        auto mix = [&](uint64_t word) {
+                for (int b = 0; b < 8; b++) {
+                        hash ^= (word >> (8 * b)) & 0xff;
+                        hash *= prime;
+                }
+        };
+
+        for (svm_row row : data) {
+                // the end node of every row separates the rows
+                for (const svm_node & node : row) {
+                        uint64_t value;
+                        std::memcpy(&value, &node.value, sizeof(value));
+                        mix(static_cast<uint64_t>(static_cast<int64_t>(node.index)));
+                        mix(value);
+                }
+        }
+        mix(data.size());
+
+        return hash;
+}
@@ -1,6 +1,7 @@
 #ifndef SVM_CONVERT_H
 #define SVM_CONVERT_H
 
+#include <cstdint>
 #include <vector>
 #include <svm.h>
 #include <thundersvm/dataset.h>
@@ -13,13 +14,25 @@ public:
 
         static svm_feature feature_to_node(const FeatureVec & vec);
 
-        static FeatureVec node_to_feature(const svm_feature & data);
+        // nodes feature_to_node needs for vec (including the end node) and writing them to out
+        static size_t node_count(const FeatureVec & vec);
+        static void fill_nodes(const FeatureVec & vec, svm_node * out);
+
+        static svm_data features_to_nodes(const std::vector<FeatureVec> & vecs);
+
+        static FeatureVec node_to_feature(svm_row data);
 
         static svm_data graph_to_nodes(const graph_access & G);
 
         static svm_data graph_part_to_nodes(const graph_access & G, const std::vector<NodeID> & sv);
 
+        // the given nodes of G, converted in parallel
+        static svm_data graph_rows_to_nodes(const graph_access & G, const std::vector<NodeID> & rows);
+
         static DataSet::node2d svmdata_to_dataset(const svm_data & data);
+
+        // 64 bit hash (FNV-1a) of all nodes and the number of rows, chained through seed
+        static uint64_t fingerprint(const svm_data & data, uint64_t seed = 0);
 };
 
 #endif /* SVM_CONVERT_H */
@@ -0,0 +1,74 @@
+#include <atomic>
+
+#include "svm/svm_data.h"
+
+uint64_t svm_data::next_version() {
+        static std::atomic<uint64_t> counter(0);
+        return ++counter;
+}
+
+svm_data::svm_data()
+        : offsets(1, 0), version(next_version()) {
+}
+
+void svm_data::reserve(size_t rows, size_t nodes) {
+        this->offsets.reserve(rows + 1);
+        this->values.reserve(nodes);
+}
+
+void svm_data::clear() {
+        this->values.clear();
+        this->offsets.assign(1, 0);
+        this->version = next_version();
+}
+
+void svm_data::push_back(svm_row row) {
+        this->values.insert(this->values.end(), row.begin(), row.end());
+        this->offsets.push_back(this->values.size());
+        this->version = next_version();
+}
+
+void svm_data::append(const svm_data & other) {
+        size_t base = this->values.size();
+        this->values.insert(this->values.end(), other.values.begin(), other.values.end());
+        this->offsets.reserve(this->offsets.size() + other.size());
+        for (size_t i = 1; i < other.offsets.size(); i++) {
+                this->offsets.push_back(base + other.offsets[i]);
+        }
+        this->version = next_version();
+}
+
+std::vector<svm_node*> svm_data::row_pointers() const {
+        std::vector<svm_node*> rows(size());
+        // libsvm takes non-const rows but only reads them
+        svm_node * first = const_cast<svm_node*>(this->values.data());
+        for (size_t i = 0; i < rows.size(); i++) {
+                rows[i] = first + this->offsets[i];
+        }
+        return rows;
+}
+
+svm_data svm_data::build(size_t n,
+                         const std::function<size_t(size_t)> & row_size,
+                         const std::function<void(size_t, svm_node *)> & fill) {
+        svm_data data;
+        data.offsets.resize(n + 1);
+        data.offsets[0] = 0;
+
+#pragma omp parallel for schedule(static) if(n > 4096)
+        for (size_t i = 0; i < n; i++) {
+                data.offsets[i + 1] = row_size(i);
+        }
+        for (size_t i = 0; i < n; i++) {
+                data.offsets[i + 1] += data.offsets[i];
+        }
+
+        data.values.resize(data.offsets[n]);
+
+#pragma omp parallel for schedule(static) if(n > 4096)
+        for (size_t i = 0; i < n; i++) {
+                fill(i, data.values.data() + data.offsets[i]);
+        }
+
+        return data;
+}
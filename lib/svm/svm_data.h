@@ -0,0 +1,94 @@
+#ifndef SVM_DATA_H
+#define SVM_DATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <svm.h>
+
+// a single sparse row, ending with a node of index -1
+typedef std::vector<svm_node> svm_feature;
+
+// read-only view of a row of svm_data (or of a svm_feature)
+class svm_row
+{
+public:
+        svm_row(const svm_node * nodes, size_t n) : nodes(nodes), n(n) {}
+        svm_row(const svm_feature & row) : nodes(row.data()), n(row.size()) {}
+
+        const svm_node * data() const { return this->nodes; }
+        size_t size() const { return this->n; }
+        const svm_node * begin() const { return this->nodes; }
+        const svm_node * end() const { return this->nodes + this->n; }
+        const svm_node & operator[](size_t i) const { return this->nodes[i]; }
+
+private:
+        const svm_node * nodes;
+        size_t n;
+};
+
+// Rows of sparse nodes in CSR layout: all nodes in one contiguous buffer,
+// row i is nodes[offsets[i], offsets[i+1]). A data set costs two allocations
+// instead of one per row and rows of a set lie next to each other.
+class svm_data
+{
+public:
+        class const_iterator
+        {
+        public:
+                const_iterator(const svm_data * data, size_t i) : data(data), i(i) {}
+                svm_row operator*() const { return (*this->data)[this->i]; }
+                const_iterator & operator++() { this->i++; return *this; }
+                bool operator!=(const const_iterator & other) const { return this->i != other.i; }
+                bool operator==(const const_iterator & other) const { return this->i == other.i; }
+
+        private:
+                const svm_data * data;
+                size_t i;
+        };
+
+        svm_data();
+
+        size_t size() const { return this->offsets.size() - 1; }
+        bool empty() const { return size() == 0; }
+        // nodes of all rows including the end nodes
+        size_t nodes() const { return this->values.size(); }
+
+        svm_row operator[](size_t i) const {
+                return svm_row(this->values.data() + this->offsets[i], this->offsets[i + 1] - this->offsets[i]);
+        }
+        svm_row back() const { return (*this)[size() - 1]; }
+
+        // changes whenever the rows change, copies share it with their source.
+        // Derived data (converted copies for other solvers) can be cached by it.
+        uint64_t id() const { return this->version; }
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, size()); }
+
+        void reserve(size_t rows, size_t nodes = 0);
+        void clear();
+
+        // appends a copy of row, pointers to rows become invalid
+        void push_back(svm_row row);
+        void append(const svm_data & other);
+
+        // first node of every row as libsvm expects them, valid as long as the data is not changed
+        std::vector<svm_node*> row_pointers() const;
+
+        // builds n rows in parallel, row_size(i) is the number of nodes of row i
+        // (including the end node) and fill(i, out) writes them to out
+        static svm_data build(size_t n,
+                              const std::function<size_t(size_t)> & row_size,
+                              const std::function<void(size_t, svm_node *)> & fill);
+
+private:
+        static uint64_t next_version();
+
+        std::vector<svm_node> values;
+        std::vector<size_t> offsets;
+        uint64_t version;
+};
+
+#endif /* SVM_DATA_H */
@@ -5,8 +5,8 @@
 #include <utility>
 #include <svm.h>
 
-typedef std::vector<svm_node> svm_feature;
-typedef std::vector<svm_feature> svm_data;
+#include "svm_data.h"
+
 typedef std::pair<float,float> svm_param;
 
 #endif /* SVM_DEFINITIONS_H */
@@ -0,0 +1,130 @@
+#include <algorithm>
+
+#include "svm/svm_distance_cache.h"
+
+size_t svm_distance_cache::budget_bytes = static_cast<size_t>(512) << 20;
+std::atomic<size_t> svm_distance_cache::used_bytes(0);
+
+static double sparse_dot(const svm_node * px, const svm_node * py) {
+        double sum = 0;
+        while (px->index != -1 && py->index != -1) {
+                if (px->index == py->index) {
+                        sum += px->value * py->value;
+                        ++px;
+                        ++py;
+                } else if (px->index > py->index) {
+                        ++py;
+                } else {
+                        ++px;
+                }
+        }
+        return sum;
+}
+
+svm_distance_cache::svm_distance_cache(svm_node * const * rows, size_t n)
+        : rows(rows), n(n), allocated_bytes(0) {
+        this->x_square.resize(n);
+        for (size_t i = 0; i < n; i++) {
+                this->x_square[i] = sparse_dot(rows[i], rows[i]);
+        }
+
+        this->blocks.resize((n + BLOCK_ROWS - 1) / BLOCK_ROWS);
+        this->state.reset(new std::atomic<unsigned char>[n]);
+        for (size_t i = 0; i < n; i++) {
+                this->state[i].store(EMPTY, std::memory_order_relaxed);
+        }
+
+        // libsvm addresses a row like a PRECOMPUTED kernel through its first node
+        this->proxy_nodes.resize(2 * n);
+        this->proxy_meta.resize(n);
+        for (size_t i = 0; i < n; i++) {
+                this->proxy_nodes[2 * i].index = 0;
+                this->proxy_nodes[2 * i].value = i;
+                this->proxy_nodes[2 * i + 1].index = -1;
+                this->proxy_meta[i] = &this->proxy_nodes[2 * i];
+        }
+
+        this->source.data = this;
+        this->source.row = &svm_distance_cache::libsvm_row;
+}
+
+svm_distance_cache::~svm_distance_cache() {
+        used_bytes.fetch_sub(this->allocated_bytes);
+}
+
+void svm_distance_cache::set_budget(size_t megabytes) {
+        budget_bytes = megabytes << 20;
+}
+
+bool svm_distance_cache::enabled() {
+        return budget_bytes > 0;
+}
+
+size_t svm_distance_cache::size() const {
+        return this->n;
+}
+
+svm_node ** svm_distance_cache::proxy_data() {
+        return this->proxy_meta.data();
+}
+
+const svm_sq_dist * svm_distance_cache::libsvm_source() const {
+        return &this->source;
+}
+
+const float * svm_distance_cache::libsvm_row(void * data, int i, float * buf) {
+        return static_cast<svm_distance_cache *>(data)->row(i, buf);
+}
+
+const float * svm_distance_cache::row(size_t i, float * buf) {
+        std::atomic<unsigned char> & row_state = this->state[i];
+        float * cached = nullptr;
+
+        unsigned char current = row_state.load(std::memory_order_acquire);
+        if (current == READY) {
+                return this->blocks[i / BLOCK_ROWS].get() + (i % BLOCK_ROWS) * this->n;
+        }
+
+        // the first thread that asks for the row fills it, all others compute their own copy
+        if (current == EMPTY && row_state.compare_exchange_strong(current, FILLING, std::memory_order_acquire)) {
+                float * block = block_of(i);
+                if (block != nullptr) {
+                        cached = block + (i % BLOCK_ROWS) * this->n;
+                        compute_row(i, cached);
+                        row_state.store(READY, std::memory_order_release);
+                        return cached;
+                }
+                row_state.store(EMPTY, std::memory_order_release);
+        }
+
+        compute_row(i, buf);
+        return buf;
+}
+
+float * svm_distance_cache::block_of(size_t i) {
+        size_t b = i / BLOCK_ROWS;
+
+        std::lock_guard<std::mutex> lock(this->block_mutex);
+        if (this->blocks[b]) {
+                return this->blocks[b].get();
+        }
+
+        size_t block_rows = std::min(BLOCK_ROWS, this->n - b * BLOCK_ROWS);
+        size_t bytes = block_rows * this->n * sizeof(float);
+        if (used_bytes.fetch_add(bytes) + bytes > budget_bytes) {
+                used_bytes.fetch_sub(bytes);
+                return nullptr;
+        }
+
+        this->blocks[b].reset(new float[block_rows * this->n]);
+        this->allocated_bytes += bytes;
+        return this->blocks[b].get();
+}
+
+void svm_distance_cache::compute_row(size_t i, float * out) const {
+        const svm_node * x = this->rows[i];
+        for (size_t j = 0; j < this->n; j++) {
+                double d = this->x_square[i] + this->x_square[j] - 2 * sparse_dot(x, this->rows[j]);
+                out[j] = static_cast<float>(std::max(d, 0.0));
+        }
+}
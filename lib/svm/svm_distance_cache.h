@@ -0,0 +1,65 @@
+#ifndef SVM_DISTANCE_CACHE_H
+#define SVM_DISTANCE_CACHE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <svm.h>
+
+// Squared distances ||x_i - x_j||^2 of all rows of an instance.
+// They do not depend on gamma, so all candidates of a sweep share them and
+// only evaluate exp(-gamma * d). Rows are filled lazily in blocks of
+// BLOCK_ROWS rows as long as the global memory budget allows it, a small
+// level thereby ends up with the full matrix. Rows that do not fit are
+// computed into the buffer of the caller.
+class svm_distance_cache
+{
+public:
+        svm_distance_cache(svm_node * const * rows, size_t n);
+        ~svm_distance_cache();
+
+        svm_distance_cache(const svm_distance_cache &) = delete;
+        svm_distance_cache & operator=(const svm_distance_cache &) = delete;
+
+        // distances of row i to all rows, buf has to hold size() floats
+        const float * row(size_t i, float * buf);
+
+        size_t size() const;
+
+        // rows as index nodes and the matching distance source for svm_train_dist
+        svm_node ** proxy_data();
+        const svm_sq_dist * libsvm_source() const;
+
+        // budget shared by all caches, 0 disables caching
+        static void set_budget(size_t megabytes);
+        static bool enabled();
+
+private:
+        enum row_state : unsigned char { EMPTY, FILLING, READY };
+
+        static constexpr size_t BLOCK_ROWS = 64;
+
+        void compute_row(size_t i, float * out) const;
+        float * block_of(size_t i);
+
+        static const float * libsvm_row(void * data, int i, float * buf);
+
+        static size_t budget_bytes;
+        static std::atomic<size_t> used_bytes;
+
+        svm_node * const * rows;
+        size_t n;
+        std::vector<double> x_square;
+
+        std::vector<std::unique_ptr<float[]>> blocks;
+        std::unique_ptr<std::atomic<unsigned char>[]> state;
+        size_t allocated_bytes;
+        std::mutex block_mutex;
+
+        std::vector<svm_node> proxy_nodes;
+        std::vector<svm_node*> proxy_meta;
+        svm_sq_dist source;
+};
+
+#endif /* SVM_DISTANCE_CACHE_H */
@@ -1,59 +1,54 @@
 #include "svm_instance.h"
 #include "svm_convert.h"
+#include "svm_result_cache.h"
 
-svm_instance::svm_instance() {
+svm_instance::svm_instance()
+        : fingerprint(0) {
 }
 
 void svm_instance::read_problem(const svm_data & min_data, const svm_data & maj_data) {
-        this->num_min = min_data.size();
-        this->num_maj = maj_data.size();
-        this->features = min_data[0].size();
-
-        allocate_prob(min_data.size() + maj_data.size(), min_data[0].size());
-
-        add_to_problem(min_data, 1);
-        add_to_problem(maj_data, -1);
+        read_problem(std::make_shared<const svm_data>(min_data), std::make_shared<const svm_data>(maj_data));
 }
 
-void svm_instance::read_problem(const graph_access & G_min, const graph_access & G_maj) {
-        this->num_min = G_min.number_of_nodes();
-        this->num_maj = G_maj.number_of_nodes();
-        this->features = G_min.getFeatureVec(0).size();
-
-        allocate_prob(G_min.number_of_nodes() + G_maj.number_of_nodes(), G_min.getFeatureVec(0).size());
+void svm_instance::read_problem(std::shared_ptr<const svm_data> min_data, std::shared_ptr<const svm_data> maj_data) {
+        this->min_rows = std::move(min_data);
+        this->maj_rows = std::move(maj_data);
 
-        add_to_problem(G_min, 1);
-        add_to_problem(G_maj, -1);
-}
+        this->num_min = this->min_rows->size();
+        this->num_maj = this->maj_rows->size();
+        this->features = this->num_min > 0 ? (*this->min_rows)[0].size() : 0;
 
-void svm_instance::allocate_prob(NodeID total_size, size_t features) {
+        NodeID total_size = this->num_min + this->num_maj;
         this->labels = std::make_shared<std::vector<double>>();
-        this->nodes = std::make_shared<svm_data>();
         this->nodes_meta = std::make_shared<std::vector<svm_node*>>();
-
         this->labels->reserve(total_size);
-        this->nodes->reserve(total_size);
         this->nodes_meta->reserve(total_size);
-}
 
-void svm_instance::add_to_problem(const svm_data & data, int label) {
-        for (NodeID node = 0; node < data.size(); node++) {
-                this->labels->push_back(label);
+        add_to_problem(*this->min_rows, 1);
+        add_to_problem(*this->maj_rows, -1);
 
-                this->nodes->push_back(data[node]);
-                this->nodes_meta->push_back(this->nodes->back().data());
+        // only the result cache reads the fingerprint
+        if (svm_result_cache_stats::enabled()) {
+                this->fingerprint = svm_convert::fingerprint(*this->maj_rows,
+                                                             svm_convert::fingerprint(*this->min_rows, this->num_min));
         }
+        this->distance_cache = std::make_shared<distance_data>();
+        this->thunder = std::make_shared<thunder_data>();
 }
 
-void svm_instance::add_to_problem(const graph_access & G, int label) {
-        forall_nodes(G, node) {
-                this->labels->push_back(label);
+void svm_instance::read_problem(const graph_access & G_min, const graph_access & G_maj) {
+        read_problem(std::make_shared<const svm_data>(svm_convert::graph_to_nodes(G_min)),
+                     std::make_shared<const svm_data>(svm_convert::graph_to_nodes(G_maj)));
 
-                const FeatureVec vec = G.getFeatureVec(node);
-                svm_feature svm_nodes = svm_convert::feature_to_node(vec);
-                this->nodes->push_back(std::move(svm_nodes));
-                this->nodes_meta->push_back(this->nodes->back().data());
-        } endfor
+        this->features = G_min.getFeatureVec(0).size();
+}
+
+void svm_instance::add_to_problem(const svm_data & data, int label) {
+        for (NodeID node = 0; node < data.size(); node++) {
+                this->labels->push_back(label);
+                // libsvm only reads the rows
+                this->nodes_meta->push_back(const_cast<svm_node*>(data[node].data()));
+        }
 }
 
 int svm_instance::size() {
@@ -68,6 +63,50 @@ svm_node** svm_instance::node_data() {
         return this->nodes_meta->data();
 }
 
-DataSet::node2d svm_instance::node_data_thunder() {
-	return svm_convert::svmdata_to_dataset(*this->nodes);
+DataSet::node2d svm_instance::node_data_thunder() const {
+	DataSet::node2d result = svm_convert::svmdata_to_dataset(*this->min_rows);
+	DataSet::node2d maj = svm_convert::svmdata_to_dataset(*this->maj_rows);
+	result.insert(result.end(), std::make_move_iterator(maj.begin()), std::make_move_iterator(maj.end()));
+	return result;
+}
+
+std::shared_ptr<const DataSet> svm_instance::dataset_thunder() const {
+	std::lock_guard<std::mutex> lock(this->thunder->mutex);
+	if (!this->thunder->dataset) {
+		DataSet::node2d nodes = node_data_thunder();
+		this->thunder->dataset = std::make_shared<const DataSet>(nodes, this->features, *this->labels);
+	}
+	return this->thunder->dataset;
+}
+
+std::shared_ptr<const svm_data> svm_instance::min_data() const {
+	return this->min_rows;
+}
+
+std::shared_ptr<const svm_data> svm_instance::maj_data() const {
+	return this->maj_rows;
+}
+
+std::shared_ptr<svm_distance_cache> svm_instance::distances() const {
+	if (!this->distance_cache || !svm_distance_cache::enabled()) {
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(this->distance_cache->mutex);
+	if (!this->distance_cache->cache) {
+		this->distance_cache->cache = std::make_shared<svm_distance_cache>(this->nodes_meta->data(), this->nodes_meta->size());
+	}
+	return this->distance_cache->cache;
+}
+
+void svm_instance::release_caches() {
+	if (this->distance_cache) {
+		// solvers still training keep their reference until they are done
+		std::lock_guard<std::mutex> lock(this->distance_cache->mutex);
+		this->distance_cache->cache.reset();
+	}
+	if (this->thunder) {
+		std::lock_guard<std::mutex> lock(this->thunder->mutex);
+		this->thunder->dataset.reset();
+	}
 }
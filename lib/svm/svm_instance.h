@@ -1,39 +1,75 @@
 #ifndef SVM_INSTANCE_H
 #define SVM_INSTANCE_H
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <thundersvm/dataset.h>
 
 #include "definitions.h"
 #include "data_structure/graph_access.h"
 #include "svm_definitions.h"
+#include "svm_distance_cache.h"
 
+// Training problem of a level: minority rows first, then majority rows.
+// The rows are not copied, the instance points into the stores it is given
+// and keeps them alive. Copies of an instance share everything.
 class svm_instance
 {
 public:
         svm_instance();
 
         void read_problem(const svm_data & min_data, const svm_data & maj_data);
+        void read_problem(std::shared_ptr<const svm_data> min_data, std::shared_ptr<const svm_data> maj_data);
         void read_problem(const graph_access & G_min, const graph_access & G_maj);
 
         int size();
         double* label_data();
         svm_node** node_data();
-	DataSet::node2d node_data_thunder();
+	DataSet::node2d node_data_thunder() const;
+	// thundersvm copy of the problem, converted on first use and shared by all copies
+	std::shared_ptr<const DataSet> dataset_thunder() const;
+
+        // squared distances of the rows, created on first use and shared by all copies,
+        // nullptr if caching is disabled
+        std::shared_ptr<svm_distance_cache> distances() const;
+
+        // frees the caches shared by all copies once the level is done,
+        // they are built again if the instance is trained once more
+        void release_caches();
+
+        // the rows of each class
+        std::shared_ptr<const svm_data> min_data() const;
+        std::shared_ptr<const svm_data> maj_data() const;
 
         NodeID num_min;
         NodeID num_maj;
         NodeID features;
 
+        // hash of the rows and the class sizes, equal instances have equal fingerprints
+        // (0 if the result cache is disabled)
+        uint64_t fingerprint;
+
         std::shared_ptr<std::vector<double>> labels;
 
 private:
-        void allocate_prob(NodeID total_size, size_t features);
         void add_to_problem(const svm_data & data, int label);
-        void add_to_problem(const graph_access & G, int label);
 
-        std::shared_ptr<svm_data> nodes;
+        std::shared_ptr<const svm_data> min_rows;
+        std::shared_ptr<const svm_data> maj_rows;
         std::shared_ptr<std::vector<svm_node*>> nodes_meta;
+
+        struct distance_data {
+                std::mutex mutex;
+                std::shared_ptr<svm_distance_cache> cache;
+        };
+        std::shared_ptr<distance_data> distance_cache;
+
+        struct thunder_data {
+                std::mutex mutex;
+                std::shared_ptr<const DataSet> dataset;
+        };
+        std::shared_ptr<thunder_data> thunder;
 };
 
 
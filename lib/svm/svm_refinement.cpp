@@ -1,10 +1,11 @@
 #include <iostream>
-#include <unordered_set>
+#include <unordered_map>
 #include <thundersvm/model/svc.h>
 #include <svm.h>
 
 #include "svm/svm_refinement.h"
 #include "svm/svm_convert.h"
+#include "svm/svm_solver_factory.h"
 #include "tools/timer.h"
 
 
@@ -18,17 +19,43 @@ svm_refinement<T>::svm_refinement(graph_hierarchy & min_hierarchy,
         this->maj_hierarchy = &maj_hierarchy;
 	this->G_min = min_hierarchy.get_coarsest();
 	this->G_maj = maj_hierarchy.get_coarsest();
-        this->uncoarsed_data_min = svm_convert::graph_to_nodes(* this->min_hierarchy->get_coarsest());
-        this->uncoarsed_data_maj = svm_convert::graph_to_nodes(* this->maj_hierarchy->get_coarsest());
+        // the initial training usually ran on the coarsest graphs, its rows can be used as they are
+        const svm_instance & initial = initial_result.instance;
+        if (initial.min_data() && initial.maj_data()
+            && initial.min_data()->size() == this->G_min->number_of_nodes()
+            && initial.maj_data()->size() == this->G_maj->number_of_nodes()) {
+                this->uncoarsed_data_min = initial.min_data();
+                this->uncoarsed_data_maj = initial.maj_data();
+        } else {
+                this->uncoarsed_data_min = std::make_shared<const svm_data>(svm_convert::graph_to_nodes(*this->G_min));
+                this->uncoarsed_data_maj = std::make_shared<const svm_data>(svm_convert::graph_to_nodes(*this->G_maj));
+        }
         this->training_inherit = false;
         this->num_skip_ms = conf.num_skip_ms;
+        this->sweep_candidates = conf.sweep_candidates;
+        this->sweep_threads = conf.sweep_threads;
+        this->warm_start = conf.warm_start;
+        this->race_fraction = conf.race_fraction;
+        this->early_exit = conf.early_exit;
+        this->approx_threshold = std::max(0, conf.approx_threshold);
+        this->approximation.kind = conf.approx_type == APPROX_NYSTROEM ? svm_approximation::NYSTROEM
+                                                                       : svm_approximation::RFF;
+        this->approximation.dimension = conf.approx_dim;
+        this->approximation.orthogonal = conf.approx_orthogonal;
+        this->approximation.seed = conf.seed;
+
+        if (this->warm_start) {
+                const svm_summary<T> & best = this->result.best();
+                this->uncoarsed_alpha_min = alpha_per_row(uncoarsed_data_min->size(), best.SV_min, best.alpha_min);
+                this->uncoarsed_alpha_maj = alpha_per_row(uncoarsed_data_maj->size(), best.SV_maj, best.alpha_maj);
+        }
 
 	// init identity data_mapping
-	this->data_mapping_min.reserve(uncoarsed_data_min.size());
+	this->data_mapping_min.reserve(uncoarsed_data_min->size());
         forall_nodes((*G_min), node) {
 		this->data_mapping_min.push_back(node);
 	} endfor
-	this->data_mapping_maj.reserve(uncoarsed_data_maj.size());
+	this->data_mapping_maj.reserve(uncoarsed_data_maj->size());
         forall_nodes((*G_maj), node) {
 		this->data_mapping_maj.push_back(node);
 	} endfor
@@ -38,6 +65,47 @@ template<class T>
 svm_refinement<T>::~svm_refinement() {
 }
 
+template<class T>
+std::unique_ptr<svm_solver<T>> svm_refinement<T>::create_solver(const svm_instance & instance) {
+	std::unique_ptr<svm_solver<T>> solver = svm_solver_factory::create<T>(instance);
+	solver->set_parallelism(this->sweep_candidates, this->sweep_threads);
+	solver->set_racing(this->race_fraction);
+	solver->set_early_exit(this->early_exit);
+
+	if (this->approx_threshold > 0 && instance.num_min + instance.num_maj >= this->approx_threshold) {
+		svm_approximation approximation = this->approximation;
+		approximation.landmarks = this->landmarks;
+		if (solver->set_approximation(approximation)) {
+			if (approximation.kind == svm_approximation::NYSTROEM && approximation.landmarks
+			    && !approximation.landmarks->empty()) {
+				std::cout << "approximate training on " << approximation.landmarks->size()
+					  << " landmarks" << std::endl;
+			} else {
+				if (approximation.kind == svm_approximation::NYSTROEM) {
+					std::cout << "no Nystroem landmarks, falling back to random features" << std::endl;
+				}
+				std::cout << "approximate training on " << approximation.dimension
+					  << " random features" << std::endl;
+			}
+		} else {
+			std::cout << "approximate training is not supported by this solver" << std::endl;
+		}
+	}
+
+	if (this->warm_start
+	    && this->uncoarsed_alpha_min.size() == this->uncoarsed_data_min->size()
+	    && this->uncoarsed_alpha_maj.size() == this->uncoarsed_data_maj->size()) {
+		// instance rows are ordered min first, then maj
+		std::vector<double> alpha;
+		alpha.reserve(this->uncoarsed_alpha_min.size() + this->uncoarsed_alpha_maj.size());
+		alpha.insert(alpha.end(), this->uncoarsed_alpha_min.begin(), this->uncoarsed_alpha_min.end());
+		alpha.insert(alpha.end(), this->uncoarsed_alpha_maj.begin(), this->uncoarsed_alpha_maj.end());
+		solver->set_initial_alpha(std::move(alpha));
+	}
+
+	return solver;
+}
+
 template<class T>
 bool svm_refinement<T>::is_done() {
         return this->min_hierarchy->isEmpty() && this->maj_hierarchy->isEmpty();
@@ -50,47 +118,128 @@ int svm_refinement<T>::get_level() {
 
 template<class T>
 void svm_refinement<T>::uncoarse(const std::vector<NodeID> & sv_min,
-				 const std::vector<NodeID> & sv_maj) {
+				 const std::vector<NodeID> & sv_maj,
+				 const std::vector<double> & alpha_min,
+				 const std::vector<double> & alpha_maj) {
+        if (this->approx_threshold > 0 && this->approximation.kind == svm_approximation::NYSTROEM) {
+                collect_landmarks(sv_min, sv_maj);
+        }
+
+        // a class that is not uncoarsed keeps its rows, so its alphas can be used as they are
+        this->uncoarsed_alpha_min = alpha_per_row(this->uncoarsed_data_min->size(), sv_min, alpha_min);
+        this->uncoarsed_alpha_maj = alpha_per_row(this->uncoarsed_data_maj->size(), sv_maj, alpha_maj);
+
         // if maj_hierarchy is larger then start by only uncoarse the maj graph
         if (!min_hierarchy->isEmpty() && min_hierarchy->size() >= maj_hierarchy->size()) {
                 std::cout << "minority uncoarsed" << std::endl;
                 this->G_min = this->min_hierarchy->pop_finer_and_project();
                 CoarseMapping* coarse_mapping_min = this->min_hierarchy->get_mapping_of_current_finer();
-                this->uncoarsed_data_min = uncoarse_SV(*this->G_min, *coarse_mapping_min, sv_min, this->data_mapping_min);
+                this->uncoarsed_data_min = std::make_shared<const svm_data>(
+                        uncoarse_SV(*this->G_min, *coarse_mapping_min, sv_min, this->data_mapping_min,
+                                    alpha_min, this->uncoarsed_alpha_min));
                 this->training_inherit = true; // after the first uncoarsening of the min data inherit params
         }
         if (!maj_hierarchy->isEmpty()) {
                 std::cout << "majority uncoarsed" << std::endl;
                 this->G_maj = this->maj_hierarchy->pop_finer_and_project();
                 CoarseMapping* coarse_mapping_maj = this->maj_hierarchy->get_mapping_of_current_finer();
-                this->uncoarsed_data_maj = uncoarse_SV(*this->G_maj, *coarse_mapping_maj, sv_maj, this->data_mapping_maj);
+                this->uncoarsed_data_maj = std::make_shared<const svm_data>(
+                        uncoarse_SV(*this->G_maj, *coarse_mapping_maj, sv_maj, this->data_mapping_maj,
+                                    alpha_maj, this->uncoarsed_alpha_maj));
         }
 }
 
+template<class T>
+void svm_refinement<T>::collect_landmarks(const std::vector<NodeID> & sv_min, const std::vector<NodeID> & sv_maj) {
+	const size_t budget = this->approximation.dimension;
+	const size_t n_min = this->G_min->number_of_nodes();
+	const size_t n_maj = this->G_maj->number_of_nodes();
+
+	// the SVs as nodes of the current graphs, evenly thinned out if there are too many
+	std::vector<NodeID> nodes_min;
+	std::vector<NodeID> nodes_maj;
+	std::vector<bool> taken(n_min + n_maj, false);
+	size_t svs = sv_min.size() + sv_maj.size();
+	for (size_t k = 0; k < svs; k++) {
+		if (svs > budget && (k * budget) / svs == ((k + 1) * budget) / svs) {
+			continue;
+		}
+		if (k < sv_min.size()) {
+			NodeID node = this->data_mapping_min[sv_min[k]];
+			nodes_min.push_back(node);
+			taken[node] = true;
+		} else {
+			NodeID node = this->data_mapping_maj[sv_maj[k - sv_min.size()]];
+			nodes_maj.push_back(node);
+			taken[n_min + node] = true;
+		}
+	}
+
+	// filled up with nodes of both classes at an even stride
+	size_t missing = budget - std::min(budget, nodes_min.size() + nodes_maj.size());
+	size_t free_nodes = n_min + n_maj - (nodes_min.size() + nodes_maj.size());
+	for (size_t k = 0, seen = 0; k < n_min + n_maj && missing > 0; k++) {
+		if (taken[k]) {
+			continue;
+		}
+		if ((seen * missing) / free_nodes != ((seen + 1) * missing) / free_nodes) {
+			if (k < n_min) {
+				nodes_min.push_back(k);
+			} else {
+				nodes_maj.push_back(k - n_min);
+			}
+		}
+		seen++;
+	}
+
+	auto rows = std::make_shared<svm_data>(svm_convert::graph_rows_to_nodes(*this->G_min, nodes_min));
+	rows->append(svm_convert::graph_rows_to_nodes(*this->G_maj, nodes_maj));
+	this->landmarks = rows;
+}
+
 template<class T>
 svm_data svm_refinement<T>::uncoarse_SV(graph_access & G,
 					const CoarseMapping & coarse_mapping,
 					const std::vector<NodeID> & sv,
-					std::vector<NodeID> & data_mapping) {
-	svm_data new_data;
+					std::vector<NodeID> & data_mapping,
+					const std::vector<double> & sv_alpha,
+					std::vector<double> & new_alpha) {
+	bool with_alpha = sv_alpha.size() == sv.size();
 
-	std::unordered_set<NodeID> sv_set;
-	sv_set.reserve(sv.size());
-	for (NodeID id : sv) {
-		sv_set.insert(data_mapping[id]);
+	// coarse node -> (alpha, number of finer nodes)
+	std::unordered_map<NodeID, std::pair<double, NodeID>> sv_map;
+	sv_map.reserve(sv.size());
+	for (size_t i = 0; i < sv.size(); i++) {
+		sv_map[data_mapping[sv[i]]] = std::make_pair(with_alpha ? sv_alpha[i] : 0.0, 0);
 	}
 
 	data_mapping.clear();
+	std::vector<NodeID> coarse_of_row;
 
         forall_nodes(G, node) {
                 NodeID coarse_node = coarse_mapping[node];
-                if (sv_set.find(coarse_node) != sv_set.end()) {
+                auto it = sv_map.find(coarse_node);
+                if (it != sv_map.end()) {
 			data_mapping.push_back(node);
-                        svm_feature feature = svm_convert::feature_to_node(G.getFeatureVec(node));
-                        new_data.push_back(std::move(feature));
+			coarse_of_row.push_back(coarse_node);
+			it->second.second++;
                 }
         endfor }
 
+	// the rows of the selected nodes are converted in parallel
+	svm_data new_data = svm_convert::graph_rows_to_nodes(G, data_mapping);
+
+	// split the alpha of a coarse SV evenly between its finer nodes,
+	// this keeps sum(alpha) per class and thereby the equality constraint
+	new_alpha.clear();
+	if (with_alpha) {
+		new_alpha.reserve(coarse_of_row.size());
+		for (NodeID coarse_node : coarse_of_row) {
+			const auto & entry = sv_map[coarse_node];
+			new_alpha.push_back(entry.first / entry.second);
+		}
+	}
+
         std::cout << "uncoarsened nodes " << G.number_of_nodes()
                   << " SV " << sv.size()
                   << " resulting new_data " << new_data.size()
@@ -99,6 +248,22 @@ svm_data svm_refinement<T>::uncoarse_SV(graph_access & G,
         return new_data;
 }
 
+template<class T>
+std::vector<double> svm_refinement<T>::alpha_per_row(size_t rows,
+						     const std::vector<NodeID> & sv,
+						     const std::vector<double> & sv_alpha) {
+	if (sv_alpha.size() != sv.size()) {
+		return std::vector<double>();
+	}
+
+	std::vector<double> alpha(rows, 0.0);
+	for (size_t i = 0; i < sv.size(); i++) {
+		alpha[sv[i]] = sv_alpha[i];
+	}
+	return alpha;
+}
+
 
 template class svm_refinement<svm_model>;
 template class svm_refinement<SVC>;
+template class svm_refinement<dense_model>;
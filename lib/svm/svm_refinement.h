@@ -4,6 +4,7 @@
 #include "definitions.h"
 #include "data_structure/graph_hierarchy.h"
 #include "svm_result.h"
+#include "svm_solver.h"
 #include "partition/partition_config.h"
 
 template<class T>
@@ -19,13 +20,22 @@ public:
         int get_level();
 
         void uncoarse(const std::vector<NodeID> & sv_min,
-		      const std::vector<NodeID> & svm_maj);
+		      const std::vector<NodeID> & svm_maj,
+		      const std::vector<double> & alpha_min,
+		      const std::vector<double> & alpha_maj);
 
 	static
 	svm_data uncoarse_SV(graph_access & G,
 			     const CoarseMapping & coarse_mapping,
 			     const std::vector<NodeID> & sv,
-			     std::vector<NodeID> & data_mapping);
+			     std::vector<NodeID> & data_mapping,
+			     const std::vector<double> & sv_alpha,
+			     std::vector<double> & new_alpha);
+
+	static
+	std::vector<double> alpha_per_row(size_t rows,
+					  const std::vector<NodeID> & sv,
+					  const std::vector<double> & sv_alpha);
 
         virtual svm_result<T> step(const svm_data & min_sample, const svm_data & maj_sample) = 0;
 
@@ -35,14 +45,33 @@ public:
 	std::vector<NodeID> data_mapping_maj;
 
 protected:
+        std::unique_ptr<svm_solver<T>> create_solver(const svm_instance & instance);
+
+        // Nystroem landmarks for the next level: the SVs of the current level,
+        // filled up with other nodes (cluster centroids) of the current graphs
+        void collect_landmarks(const std::vector<NodeID> & sv_min, const std::vector<NodeID> & sv_maj);
+
         graph_hierarchy * min_hierarchy;
         graph_hierarchy * maj_hierarchy;
-        svm_data uncoarsed_data_min;
-        svm_data uncoarsed_data_maj;
+        // rows of the current level, shared with the instances built from them
+        std::shared_ptr<const svm_data> uncoarsed_data_min;
+        std::shared_ptr<const svm_data> uncoarsed_data_maj;
+        // warm start alphas aligned with uncoarsed_data_min / uncoarsed_data_maj
+        std::vector<double> uncoarsed_alpha_min;
+        std::vector<double> uncoarsed_alpha_maj;
         svm_result<T> result;
 
         bool training_inherit;
         int num_skip_ms;
+        int sweep_candidates;
+        int sweep_threads;
+        bool warm_start;
+        double race_fraction;
+        bool early_exit;
+        // levels with at least approx_threshold rows are trained approximately (0 = off)
+        NodeID approx_threshold;
+        svm_approximation approximation;
+        std::shared_ptr<const svm_data> landmarks;
 };
 
 #endif /* REFINEMENT_H */
@@ -1,8 +1,19 @@
 #include <algorithm>
 
 #include <thundersvm/model/svc.h>
+#include "dense_model.h"
 #include "svm_result.h"
 
+size_t svm_result_limits::kept = 4;
+
+void svm_result_limits::set_models_kept(size_t models) {
+        kept = models;
+}
+
+size_t svm_result_limits::models_kept() {
+        return kept;
+}
+
 template<class T>
 svm_result<T>::svm_result(const svm_instance & instance)
 	: instance(instance) {
@@ -25,10 +36,61 @@ void svm_result<T>::add(const svm_result<T> & result) {
         this->add(result.summaries);
 }
 
+template<class T>
+void svm_result<T>::add(const svm_summary<T> & summary) {
+        this->add(std::vector<svm_summary<T>>(1, summary));
+}
+
+// candidates dropped by racing were only scored on a slice and never win,
+// summaries whose model was dropped stay behind the ones that still have one
+template<class T>
+static bool better(const svm_summary<T> & a, const svm_summary<T> & b) {
+        if (a.pruned != b.pruned) {
+                return b.pruned;
+        }
+        if (a.has_model() != b.has_model()) {
+                return a.has_model();
+        }
+        return summary_cmp_better_gmean_sv::comp(a, b);
+}
+
+// insertion sort, summary_cmp_better_gmean_sv is no strict weak ordering
+// (the gmean tolerance is not transitive) so std::sort can't be used
+template<class T>
+static void insertion_sort(std::vector<svm_summary<T>> & summaries) {
+        size_t j;
+
+        for (size_t i = 0; i < summaries.size(); i++){
+                j = i;
+
+                while (j > 0 && better(summaries[j], summaries[j-1])) {
+                        svm_summary<T> temp = std::move(summaries[j]);
+                        summaries[j] = std::move(summaries[j-1]);
+                        summaries[j-1] = std::move(temp);
+                        j--;
+                }
+        }
+}
+
 template<class T>
 void svm_result<T>::add(const std::vector<svm_summary<T>> & to_add) {
-        this->summaries.insert(this->summaries.end(), to_add.begin(), to_add.end());
-        this->sort_summaries();
+        // only the new ones are sorted, then both sorted lists are merged in one pass
+        std::vector<svm_summary<T>> added(to_add);
+        insertion_sort(added);
+
+        std::vector<svm_summary<T>> merged;
+        merged.reserve(this->summaries.size() + added.size());
+        size_t i = 0, j = 0;
+        while (i < this->summaries.size() || j < added.size()) {
+                // on equal scores the present one comes first
+                if (j < added.size() && (i == this->summaries.size() || better(added[j], this->summaries[i]))) {
+                        merged.push_back(std::move(added[j++]));
+                } else {
+                        merged.push_back(std::move(this->summaries[i++]));
+                }
+        }
+        this->summaries = std::move(merged);
+        drop_models();
 }
 
 template<class T>
@@ -44,23 +106,23 @@ std::vector<svm_param> svm_result<T>::all_params() {
 
 template<class T>
 void svm_result<T>::sort_summaries() {
-        // insertion_sort
-        size_t j;
-
-        for (size_t i = 0; i < this->summaries.size(); i++){
-                j = i;
+        insertion_sort(this->summaries);
+        drop_models();
+}
 
-                while (j > 0 && summary_cmp_better_gmean_sv::comp(this->summaries[j], this->summaries[j-1])) {
-                        svm_summary<T> temp = std::move(this->summaries[j]);
-                        this->summaries[j] = std::move(this->summaries[j-1]);
-                        this->summaries[j-1] = std::move(temp);
-                        j--;
-                }
+template<class T>
+void svm_result<T>::drop_models() {
+        size_t kept = svm_result_limits::models_kept();
+        if (kept == 0) {
+                return;
+        }
+        for (size_t i = kept; i < this->summaries.size(); i++) {
+                this->summaries[i].drop_model();
         }
 }
 
 template<class T>
-size_t svm_result<T>::get_best_index(const std::vector<std::pair<svm_summary<T>,svm_instance>> vec) {
+size_t svm_result<T>::get_best_index(const std::vector<std::pair<svm_summary<T>,svm_instance>> & vec) {
         size_t best_index = 0;
 
         for (size_t i = 1; i < vec.size(); i++) {
@@ -73,3 +135,4 @@ size_t svm_result<T>::get_best_index(const std::vector<std::pair<svm_summary<T>,
 
 template class svm_result<svm_model>;
 template class svm_result<SVC>;
+template class svm_result<dense_model>;
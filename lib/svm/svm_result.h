@@ -7,6 +7,20 @@
 #include "svm_summary.h"
 #include "svm_instance.h"
 
+// number of summaries of a result that keep their model and SVs,
+// the others are only kept as scores (0 = all)
+class svm_result_limits
+{
+public:
+        static void set_models_kept(size_t models);
+        static size_t models_kept();
+
+private:
+        static size_t kept;
+};
+
+// Summaries of the candidates of a level, best first. Only the best
+// svm_result_limits::models_kept() of them keep their models.
 template<class T>
 class svm_result
 {
@@ -18,7 +32,9 @@ public:
 
         void sort_summaries();
 
+        // adds the summaries and sorts again, on equal scores the present ones come first
         void add(const std::vector<svm_summary<T>> & to_add);
+        void add(const svm_summary<T> & summary);
         void add(const svm_result<T> & result);
 
         std::vector<svm_param> all_params();
@@ -26,7 +42,10 @@ public:
         std::vector<svm_summary<T>> summaries;
         svm_instance instance;
 
-        static size_t get_best_index(const std::vector<std::pair<svm_summary<T>,svm_instance>> vec);
+        static size_t get_best_index(const std::vector<std::pair<svm_summary<T>,svm_instance>> & vec);
+
+private:
+        void drop_models();
 };
 
 
@@ -0,0 +1,97 @@
+#include <cmath>
+#include <thundersvm/model/svc.h>
+
+#include "svm/dense_model.h"
+#include "svm/svm_convert.h"
+#include "svm/svm_result.h"
+#include "svm/svm_result_cache.h"
+
+bool svm_result_cache_stats::active = true;
+std::atomic<size_t> svm_result_cache_stats::hit_count(0);
+std::atomic<size_t> svm_result_cache_stats::miss_count(0);
+
+void svm_result_cache_stats::set_enabled(bool enabled) {
+        active = enabled;
+}
+
+bool svm_result_cache_stats::enabled() {
+        return active;
+}
+
+size_t svm_result_cache_stats::hits() {
+        return hit_count.load();
+}
+
+size_t svm_result_cache_stats::misses() {
+        return miss_count.load();
+}
+
+void svm_result_cache_stats::reset() {
+        hit_count = 0;
+        miss_count = 0;
+}
+
+template<class T>
+constexpr double svm_result_cache<T>::QUANTUM;
+
+template<class T>
+typename svm_result_cache<T>::key svm_result_cache<T>::make_key(uint64_t data_key, svm_param p) {
+        return std::make_tuple(data_key, std::llround(p.first / QUANTUM), std::llround(p.second / QUANTUM));
+}
+
+template<class T>
+bool svm_result_cache<T>::same(svm_param a, svm_param b) {
+        return make_key(0, a) == make_key(0, b);
+}
+
+template<class T>
+bool svm_result_cache<T>::lookup(uint64_t data_key, svm_param p, svm_summary<T> & summary) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        auto it = this->summaries.find(make_key(data_key, p));
+        if (it == this->summaries.end()) {
+                miss_count++;
+                return false;
+        }
+        hit_count++;
+        summary = it->second;
+        return true;
+}
+
+template<class T>
+void svm_result_cache<T>::store(uint64_t data_key, svm_param p, const svm_summary<T> & summary) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->summaries.emplace(make_key(data_key, p), summary);
+
+        size_t kept = svm_result_limits::models_kept();
+        if (kept == 0 || this->summaries.size() <= kept) {
+                return;
+        }
+
+        // drop the worst one, its model would be dropped by the result anyway
+        auto worst = this->summaries.begin();
+        for (auto it = std::next(worst); it != this->summaries.end(); ++it) {
+                if (summary_cmp_better_gmean_sv::comp(worst->second, it->second)) {
+                        worst = it;
+                }
+        }
+        this->summaries.erase(worst);
+}
+
+template<class T>
+uint64_t svm_result_cache<T>::data_key(uint64_t instance_fingerprint, const svm_data & min_sample, const svm_data & maj_sample) {
+        std::lock_guard<std::mutex> lock(this->data_mutex);
+
+        data_ids ids = std::make_tuple(instance_fingerprint, min_sample.id(), maj_sample.id());
+        if (!this->has_data_key || ids != this->last_data) {
+                uint64_t key = svm_convert::fingerprint(min_sample, instance_fingerprint);
+                this->last_data_key = svm_convert::fingerprint(maj_sample, key);
+                this->last_data = ids;
+                this->has_data_key = true;
+        }
+        return this->last_data_key;
+}
+
+template class svm_result_cache<svm_model>;
+template class svm_result_cache<SVC>;
+template class svm_result_cache<dense_model>;
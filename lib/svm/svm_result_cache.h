@@ -0,0 +1,69 @@
+#ifndef SVM_RESULT_CACHE_H
+#define SVM_RESULT_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "svm_definitions.h"
+#include "svm_summary.h"
+
+// switch and hit/miss counters shared by the caches of all model types
+class svm_result_cache_stats
+{
+public:
+        static void set_enabled(bool enabled);
+        static bool enabled();
+
+        static size_t hits();
+        static size_t misses();
+        static void reset();
+
+protected:
+        static bool active;
+        static std::atomic<size_t> hit_count;
+        static std::atomic<size_t> miss_count;
+};
+
+// Summaries (model, SVs, scores) of trained candidates, so a (C, gamma) pair that
+// comes up again on the same level (the inherited parameters, the center of the
+// second UD sweep, BO revisiting a point) is not trained again.
+// Keyed by the fingerprints of the instance and the validation data and by
+// log C / log gamma rounded to QUANTUM. A solver shares it with its clones.
+// Like svm_result only the best svm_result_limits::models_kept() summaries are
+// kept, a parameter that lost against them is trained again if it comes up.
+template<class T>
+class svm_result_cache : public svm_result_cache_stats
+{
+public:
+        static constexpr double QUANTUM = 1e-3;
+
+        // data_key: combined fingerprint of the instance and the validation data
+        bool lookup(uint64_t data_key, svm_param p, svm_summary<T> & summary);
+        void store(uint64_t data_key, svm_param p, const svm_summary<T> & summary);
+
+        // the validation data is only hashed when its svm_data::id() changes
+        uint64_t data_key(uint64_t instance_fingerprint, const svm_data & min_sample, const svm_data & maj_sample);
+
+        // true if both parameters end up at the same key
+        static bool same(svm_param a, svm_param b);
+
+private:
+        typedef std::tuple<uint64_t, long long, long long> key;
+
+        typedef std::tuple<uint64_t, uint64_t, uint64_t> data_ids;
+
+        static key make_key(uint64_t data_key, svm_param p);
+
+        std::mutex mutex;
+        std::map<key, svm_summary<T>> summaries;
+
+        std::mutex data_mutex;
+        data_ids last_data{0, 0, 0};
+        uint64_t last_data_key = 0;
+        bool has_data_key = false;
+};
+
+#endif /* SVM_RESULT_CACHE_H */
@@ -3,8 +3,11 @@
 #include <algorithm>
 #include <cmath>
 #include <functional>
+#include <omp.h>
 #include <thundersvm/model/svc.h>
 
+#include "svm/dense_kernels.h"
+#include "svm/dense_model.h"
 #include "svm/param_search.h"
 #include "svm/svm_solver.h"
 #include "svm/svm_convert.h"
@@ -28,6 +31,10 @@ svm_solver<T>::svm_solver(const svm_instance & instance)
         this->param.nr_weight = 0;
         this->param.weight_label = NULL;
         this->param.weight = NULL;
+
+        if (svm_result_cache_stats::enabled()) {
+                this->result_cache = std::make_shared<svm_result_cache<T>>();
+        }
 }
 
 template<class T>
@@ -54,44 +61,306 @@ svm_result<T> svm_solver<T>::train_grid(const svm_data & min_sample, const svm_d
         return result;
 }
 
+namespace {
+
+// z value of the racing confidence bounds (95%)
+const double RACE_Z = 1.96;
+
+// racing is skipped if the slice would have fewer samples in a class
+const size_t RACE_MIN_SAMPLES = 30;
+
+// the validation data is scored in this many rounds with early exit
+const size_t EARLY_EXIT_ROUNDS = 8;
+
+// Wilson score interval of the proportion hits / n
+void wilson_bounds(size_t hits, size_t n, double & lower, double & upper) {
+	if (n == 0) {
+		lower = 0;
+		upper = 1;
+		return;
+	}
+	double p = (double) hits / n;
+	double z2 = RACE_Z * RACE_Z;
+	double denom = 1 + z2 / n;
+	double center = (p + z2 / (2 * n)) / denom;
+	double half = RACE_Z * std::sqrt(p * (1 - p) / n + z2 / (4.0 * n * n)) / denom;
+	lower = std::max(0.0, center - half);
+	upper = std::min(1.0, center + half);
+}
+
+template<class T>
+void gmean_bounds(const svm_summary<T> & s, double & lower, double & upper) {
+	double sn_lower, sn_upper, sp_lower, sp_upper;
+	wilson_bounds(s.TP, s.TP + s.FN, sn_lower, sn_upper);
+	wilson_bounds(s.TN, s.TN + s.FP, sp_lower, sp_upper);
+	lower = std::sqrt(sn_lower * sp_lower);
+	upper = std::sqrt(sn_upper * sp_upper);
+}
+
+// every k-th sample so the slice follows the order of the validation data
+svm_data stride_slice(const svm_data & data, size_t k) {
+	svm_data slice;
+	slice.reserve(data.size() / k + 1);
+	for (size_t i = 0; i < data.size(); i += k) {
+		slice.push_back(data[i]);
+	}
+	return slice;
+}
+
+// decision values of the models of score_fused on both validation sets,
+// M is the dense_matrix type (and so the precision) of the kernel
+template<class M>
+void fused_decisions(const std::vector<svm_node*> & rows, const svm_data & min_sample, const svm_data & maj_sample,
+		     const std::vector<std::vector<size_t>> & index, const std::vector<std::vector<double>> & coef,
+		     const std::vector<double> & rho, double gamma, std::vector<std::vector<double>> & dec) {
+	M SV = M::from_nodes(rows.data(), rows.size());
+	M X(min_sample.size() + maj_sample.size(), SV.features);
+	X.append_data(min_sample);
+	X.append_data(maj_sample);
+
+	dense_kernels::rbf_decisions(X, SV, index, coef, rho, gamma, dec);
+}
+
+// the samples begin <= i < end
+svm_data range_slice(const svm_data & data, size_t begin, size_t end) {
+	svm_data slice;
+	slice.reserve(end - begin);
+	for (size_t i = begin; i < end; i++) {
+		slice.push_back(data[i]);
+	}
+	return slice;
+}
+
+}
+
+template<class T>
+void svm_solver<T>::for_candidates(size_t n, int candidates, const std::function<void(svm_solver<T> &, size_t)> & run) {
+	candidates = std::min(candidates, static_cast<int>(n));
+
+	if (candidates <= 1) {
+		for (size_t i = 0; i < n; i++) {
+			run(*this, i);
+		}
+		return;
+	}
+
+	int threads = this->sweep_threads;
+	if (threads <= 0) {
+		threads = std::max(1, omp_get_max_threads() / candidates);
+	}
+
+	// the backends parallelize a single training themselves
+	int old_levels = omp_get_max_active_levels();
+	omp_set_max_active_levels(std::max(old_levels, 2));
+
+#pragma omp parallel for num_threads(candidates) schedule(dynamic, 1)
+	for (size_t i = 0; i < n; i++) {
+		omp_set_num_threads(threads);
+
+		// every candidate trains on its own copy of the solver state
+		std::unique_ptr<svm_solver<T>> worker = this->clone();
+		run(*worker, i);
+	}
+
+	omp_set_max_active_levels(old_levels);
+}
+
 template<class T>
 svm_result<T> svm_solver<T>::train_range(const std::vector<svm_param> & params,
 					 const svm_data & min_sample,
 					 const svm_data & maj_sample) {
+	if (this->race_fraction > 0 && this->race_fraction < 1 && params.size() > 1
+	    && std::min(min_sample.size(), maj_sample.size()) * this->race_fraction >= RACE_MIN_SAMPLES) {
+		return race_range(params, min_sample, maj_sample);
+	}
+
+	std::vector<svm_summary<T>> summaries = train_batch(params, min_sample, maj_sample, this->sweep_candidates,
+							    this->early_exit);
+
+        return svm_result<T>(summaries, this->instance);
+}
+
+template<class T>
+std::vector<svm_summary<T>> svm_solver<T>::train_batch(const std::vector<svm_param> & params,
+						       const svm_data & min_sample,
+						       const svm_data & maj_sample,
+						       int candidates,
+						       bool early_exit) {
+	// one slot per parameter so the result does not depend on the finishing order
+	std::vector<std::unique_ptr<svm_summary<T>>> slots(params.size());
+
+	// with the cache a repeated parameter is only trained once, its copies are
+	// taken from the cache afterwards (concurrently both would miss)
+	std::vector<size_t> unique;
+	std::vector<size_t> repeated;
+	for (size_t i = 0; i < params.size(); i++) {
+		bool seen = false;
+		for (size_t j = 0; this->result_cache && j < unique.size() && !seen; j++) {
+			seen = svm_result_cache<T>::same(params[unique[j]], params[i]);
+		}
+		(seen ? repeated : unique).push_back(i);
+	}
+
+	// candidates that share gamma with another one are scored together once all
+	// are trained, so each kernel value to the validation data is computed once
+	std::vector<char> same_gamma(params.size(), false);
+	for (size_t a = 0; a < unique.size() && this->fused_scoring(); a++) {
+		for (size_t b = a + 1; b < unique.size(); b++) {
+			if (params[unique[a]].second == params[unique[b]].second) {
+				same_gamma[unique[a]] = true;
+				same_gamma[unique[b]] = true;
+			}
+		}
+	}
+
+	uint64_t data_key = 0;
+	if (this->result_cache) {
+		data_key = this->result_cache->data_key(this->instance.fingerprint, min_sample, maj_sample);
+	}
+
+	std::vector<svm_decision> decisions(params.size());
+	std::vector<double> train_times(params.size());
+	std::vector<char> pending(params.size(), false);
+
+	// best Gmean of the finished candidates
+	double incumbent = 0;
+
+	for_candidates(unique.size(), candidates, [&](svm_solver<T> & solver, size_t k) {
+		size_t i = unique[k];
+		if (!same_gamma[i]) {
+			double current;
+#pragma omp critical (svm_solver_incumbent)
+			current = incumbent;
+
+			slots[i] = std::make_unique<svm_summary<T>>(solver.train_single(params[i], min_sample, maj_sample,
+											  early_exit ? current : 0));
+			if (!slots[i]->pruned) {
+#pragma omp critical (svm_solver_incumbent)
+				incumbent = std::max(incumbent, slots[i]->Gmean);
+			}
+			return;
+		}
+
+		svm_summary<T> cached(0, 0, 0, 0);
+		if (solver.from_cache(data_key, params[i], cached)) {
+			slots[i] = std::make_unique<svm_summary<T>>(cached);
+			return;
+		}
+
+		train_times[i] = solver.train_param(params[i]);
+		if (solver.get_decision(decisions[i])) {
+			// scored below
+			slots[i] = std::make_unique<svm_summary<T>>(solver.make_summary(0, 0, 0, 0));
+			pending[i] = true;
+		} else {
+			slots[i] = std::make_unique<svm_summary<T>>(solver.build_summary(min_sample, maj_sample));
+			if (solver.result_cache) {
+				solver.result_cache->store(data_key, params[i], *slots[i]);
+			}
+			solver.print_candidate(params[i], train_times[i], *slots[i]);
+		}
+	});
+
+	this->score_fused(slots, decisions, pending, min_sample, maj_sample);
+	for (size_t i = 0; i < params.size(); i++) {
+		if (pending[i]) {
+			if (this->result_cache) {
+				this->result_cache->store(data_key, params[i], *slots[i]);
+			}
+			this->print_candidate(params[i], train_times[i], *slots[i]);
+		}
+	}
+
+	for (size_t i : repeated) {
+		slots[i] = std::make_unique<svm_summary<T>>(this->train_single(params[i], min_sample, maj_sample));
+	}
+
 	std::vector<svm_summary<T>> summaries;
+	summaries.reserve(slots.size());
+	for (auto & slot : slots) {
+		summaries.push_back(std::move(*slot));
+	}
+	return summaries;
+}
 
-// #pragma omp parallel for
-	for (auto&& p : params) {
-		auto summary = train_single(p, min_sample, maj_sample);
+template<class T>
+svm_result<T> svm_solver<T>::race_range(const std::vector<svm_param> & params,
+					const svm_data & min_sample,
+					const svm_data & maj_sample) {
+	size_t k = std::max<size_t>(2, std::lround(1 / this->race_fraction));
+	svm_data min_slice = stride_slice(min_sample, k);
+	svm_data maj_slice = stride_slice(maj_sample, k);
+
+	// train every candidate and score it on the slice
+	std::vector<std::unique_ptr<svm_summary<T>>> slots(params.size());
+	std::vector<double> train_times(params.size());
+
+	for_candidates(params.size(), this->sweep_candidates, [&](svm_solver<T> & solver, size_t i) {
+		train_times[i] = solver.train_param(params[i]);
+		slots[i] = std::make_unique<svm_summary<T>>(solver.build_summary(min_slice, maj_slice));
+	});
+
+	// the leader is the candidate with the best lower bound, everything
+	// that can't come within the gmean tolerance of it even with its upper
+	// bound is dropped, those within it could still win on fewer SVs
+	std::vector<double> upper(params.size());
+	double leader = 0;
+	for (size_t i = 0; i < params.size(); i++) {
+		double lower;
+		gmean_bounds(*slots[i], lower, upper[i]);
+		leader = std::max(leader, lower);
+	}
 
-// #pragma omp critical
-		{
-                summaries.push_back(summary);
+	// the survivors are scored on all validation data
+	for_candidates(params.size(), this->sweep_candidates, [&](svm_solver<T> & solver, size_t i) {
+		if (upper[i] < leader - EARLY_EXIT_RANGE) {
+			slots[i]->pruned = true;
+		} else {
+			solver.param.C = slots[i]->C;
+			solver.param.gamma = slots[i]->gamma;
+			solver.set_model(slots[i]->model);
+			slots[i] = std::make_unique<svm_summary<T>>(solver.build_summary(min_sample, maj_sample));
 		}
-        }
+		solver.print_candidate(params[i], train_times[i], *slots[i]);
+	});
+
+	std::vector<svm_summary<T>> summaries;
+	summaries.reserve(slots.size());
+	for (auto & slot : slots) {
+		summaries.push_back(std::move(*slot));
+	}
 
         return svm_result<T>(summaries, this->instance);
 }
 
 template<class T>
-svm_summary<T> svm_solver<T>::train_single(svm_param p,
-					   const svm_data & min_sample,
-					   const svm_data & maj_sample) {
+double svm_solver<T>::train_param(svm_param p) {
 	timer t;
 
 	this->param.C = pow(2, p.first);
 	this->param.gamma = pow(2, p.second);
 
-	std::cout << std::setprecision(2)
-		  << std::fixed
-		  << "log C=" << std::setw(6) << p.first
-		  << "\tlog gamma=" << std::setw(6) << p.second
-		  << std::flush;
-
 	this->train();
 
-	std::cout << "\ttime=" << t.elapsed()
-		  << std::flush;
+	return t.elapsed();
+}
+
+template<class T>
+svm_summary<T> svm_solver<T>::train_single(svm_param p,
+					   const svm_data & min_sample,
+					   const svm_data & maj_sample,
+					   double incumbent) {
+	uint64_t data_key = 0;
+	if (this->result_cache) {
+		data_key = this->result_cache->data_key(this->instance.fingerprint, min_sample, maj_sample);
+
+		svm_summary<T> cached(0, 0, 0, 0);
+		if (this->from_cache(data_key, p, cached)) {
+			return cached;
+		}
+	}
+
+	double train_time = this->train_param(p);
 
 	// if (cur_solver.model->l > (cur_solver.instance.num_min + cur_solver.instance.num_maj) * 0.9
 	//     && !summaries.empty()) {
@@ -101,16 +370,178 @@ svm_summary<T> svm_solver<T>::train_single(svm_param p,
 	//         continue;
 	// }
 
-	svm_summary<T> summary = this->build_summary(min_sample, maj_sample);
-	summary.print_short();
+	svm_summary<T> summary = incumbent > 0
+		? this->score_early_exit(min_sample, maj_sample, incumbent)
+		: this->build_summary(min_sample, maj_sample);
+	if (this->result_cache && !summary.pruned) {
+		this->result_cache->store(data_key, p, summary);
+	}
+
+	this->print_candidate(p, train_time, summary);
 	return summary;
 }
 
+template<class T>
+svm_summary<T> svm_solver<T>::score_early_exit(const svm_data & min_sample, const svm_data & maj_sample,
+					       double incumbent) {
+	if (min_sample.empty() || maj_sample.empty()) {
+		return this->build_summary(min_sample, maj_sample);
+	}
+
+	// both classes are scored in the same proportion every round
+	size_t min_step = (min_sample.size() + EARLY_EXIT_ROUNDS - 1) / EARLY_EXIT_ROUNDS;
+	size_t maj_step = (maj_sample.size() + EARLY_EXIT_ROUNDS - 1) / EARLY_EXIT_ROUNDS;
+
+	size_t tp = 0, tn = 0, fp = 0, fn = 0;
+	size_t min_done = 0, maj_done = 0;
+	bool pruned = false;
+
+	while (min_done < min_sample.size() || maj_done < maj_sample.size()) {
+		size_t min_end = std::min(min_done + min_step, min_sample.size());
+		size_t maj_end = std::min(maj_done + maj_step, maj_sample.size());
+
+		// the slices are predicted by the backend, so the counts are the ones of build_summary
+		auto predicted = this->predict_min_maj(range_slice(min_sample, min_done, min_end),
+						       range_slice(maj_sample, maj_done, maj_end));
+		for (int res : predicted.first) {
+			res == 1 ? tp++ : fn++;
+		}
+		for (int res : predicted.second) {
+			res == -1 ? tn++ : fp++;
+		}
+		min_done = min_end;
+		maj_done = maj_end;
+
+		// everything not scored yet is assumed to be right
+		double sens = (double) (tp + min_sample.size() - min_done) / min_sample.size();
+		double spec = (double) (tn + maj_sample.size() - maj_done) / maj_sample.size();
+		if (std::sqrt(sens * spec) < incumbent - EARLY_EXIT_RANGE) {
+			pruned = true;
+			break;
+		}
+	}
+
+	svm_summary<T> summary = this->make_summary(tp, tn, fp, fn);
+	summary.pruned = pruned;
+	return summary;
+}
+
+template<class T>
+bool svm_solver<T>::from_cache(uint64_t data_key, svm_param p, svm_summary<T> & summary) {
+	if (!this->result_cache || !this->result_cache->lookup(data_key, p, summary)) {
+		return false;
+	}
+
+	// leave the solver as if it had been trained
+	this->param.C = summary.C;
+	this->param.gamma = summary.gamma;
+	this->set_model(summary.model);
+	this->print_candidate(p, 0, summary);
+	return true;
+}
+
+template<class T>
+void svm_solver<T>::score_fused(std::vector<std::unique_ptr<svm_summary<T>>> & slots,
+				const std::vector<svm_decision> & decisions,
+				const std::vector<char> & pending,
+				const svm_data & min_sample,
+				const svm_data & maj_sample) {
+	std::vector<char> done(slots.size(), false);
+
+	for (size_t first = 0; first < slots.size(); first++) {
+		if (!pending[first] || done[first]) {
+			continue;
+		}
+
+		// all pending candidates with this gamma
+		std::vector<size_t> group;
+		for (size_t i = first; i < slots.size(); i++) {
+			if (pending[i] && !done[i] && slots[i]->gamma == slots[first]->gamma) {
+				group.push_back(i);
+				done[i] = true;
+			}
+		}
+
+		// union of their SVs, every instance row once
+		std::vector<int> position(this->instance.size(), -1);
+		std::vector<svm_node*> rows;
+		std::vector<std::vector<size_t>> index(group.size());
+		std::vector<std::vector<double>> coef(group.size());
+		std::vector<double> rho(group.size());
+		for (size_t m = 0; m < group.size(); m++) {
+			const svm_decision & d = decisions[group[m]];
+			for (int row : d.rows) {
+				if (position[row] < 0) {
+					position[row] = rows.size();
+					rows.push_back(this->instance.node_data()[row]);
+				}
+				index[m].push_back(position[row]);
+			}
+			coef[m] = d.coef;
+			rho[m] = d.rho;
+		}
+
+		std::vector<std::vector<double>> dec;
+		if (this->double_decision()) {
+			fused_decisions<dense_matrix_double>(rows, min_sample, maj_sample, index, coef, rho,
+							     slots[first]->gamma, dec);
+		} else {
+			fused_decisions<dense_matrix>(rows, min_sample, maj_sample, index, coef, rho,
+						      slots[first]->gamma, dec);
+		}
+
+		// a positive decision value votes for the minority class
+		for (size_t m = 0; m < group.size(); m++) {
+			size_t tp = 0, tn = 0, fp = 0, fn = 0;
+			for (size_t i = 0; i < min_sample.size(); i++) {
+				dec[m][i] > 0 ? tp++ : fn++;
+			}
+			for (size_t i = min_sample.size(); i < dec[m].size(); i++) {
+				dec[m][i] > 0 ? fp++ : tn++;
+			}
+			slots[group[m]]->set_counts(tp, tn, fp, fn);
+		}
+	}
+}
+
+template<class T>
+void svm_solver<T>::print_candidate(svm_param p, double train_time, svm_summary<T> & summary) {
+	// candidates of a sweep may run concurrently so print each line at once
+#pragma omp critical (svm_solver_output)
+	{
+	std::cout << std::setprecision(2)
+		  << std::fixed
+		  << "log C=" << std::setw(6) << p.first
+		  << "\tlog gamma=" << std::setw(6) << p.second
+		  << "\ttime=" << train_time
+		  << (summary.pruned ? " pruned" : "")
+		  << std::flush;
+	summary.print_short();
+	}
+}
+
+template<class T>
+bool svm_solver<T>::fused_scoring() const {
+	return false;
+}
+
+template<class T>
+bool svm_solver<T>::get_decision(svm_decision & decision) {
+	return false;
+}
+
+template<class T>
+bool svm_solver<T>::double_decision() const {
+	return false;
+}
+
 template<class T>
 svm_summary<T> svm_solver<T>::build_summary(const svm_data & min, const svm_data & maj) {
 	size_t tp = 0, tn = 0, fp = 0, fn = 0;
 
-	for (int res : this->predict_batch(min)) {
+	auto predicted = this->predict_min_maj(min, maj);
+
+	for (int res : predicted.first) {
 		if (res == 1) {
 			tp++;
 		} else {
@@ -118,7 +549,7 @@ svm_summary<T> svm_solver<T>::build_summary(const svm_data & min, const svm_data
                 }
         }
 
-        for (int res : this->predict_batch(maj)) {
+        for (int res : predicted.second) {
                 if (res == -1) {
                         tn++;
                 } else {
@@ -126,13 +557,21 @@ svm_summary<T> svm_solver<T>::build_summary(const svm_data & min, const svm_data
                 }
         }
 
+	return this->make_summary(tp, tn, fp, fn);
+}
+
+template<class T>
+svm_summary<T> svm_solver<T>::make_summary(size_t tp, size_t tn, size_t fp, size_t fn) {
 	auto SV_pair = this->get_SV();
+	auto alpha_pair = this->get_SV_alpha();
 
 	svm_summary<T> summary(tp, tn, fp, fn);
 
         summary.model = model;
 	summary.SV_min = SV_pair.first;
 	summary.SV_maj = SV_pair.second;
+	summary.alpha_min = alpha_pair.first;
+	summary.alpha_maj = alpha_pair.second;
 	summary.C = this->param.C;
 	summary.gamma = this->param.gamma;
         summary.C_log = std::log(this->param.C) / std::log(2);
@@ -151,6 +590,11 @@ std::vector<int> svm_solver<T>::predict_batch(const svm_data & data) {
 	return result;
 }
 
+template<class T>
+std::pair<std::vector<int>, std::vector<int>> svm_solver<T>::predict_min_maj(const svm_data & min, const svm_data & maj) {
+	return std::make_pair(this->predict_batch(min), this->predict_batch(maj));
+}
+
 template<class T>
 void svm_solver<T>::set_C(float C) {
         this->param.C = C;
@@ -161,6 +605,16 @@ void svm_solver<T>::set_gamma(float gamma) {
         this->param.gamma = gamma;
 }
 
+template<class T>
+bool svm_solver<T>::compact(size_t budget) {
+	return false;
+}
+
+template<class T>
+bool svm_solver<T>::set_approximation(const svm_approximation & approximation) {
+	return false;
+}
+
 template<class T>
 void svm_solver<T>::set_model(std::shared_ptr<T> new_model) {
 	this->model = new_model;
@@ -171,5 +625,30 @@ const svm_instance & svm_solver<T>::get_instance() {
 	return this->instance;
 }
 
+template<class T>
+void svm_solver<T>::set_parallelism(int candidates, int threads) {
+	this->sweep_candidates = std::max(1, candidates);
+	this->sweep_threads = std::max(0, threads);
+}
+
+template<class T>
+void svm_solver<T>::set_initial_alpha(std::vector<double> alpha) {
+	this->initial_alpha = std::move(alpha);
+}
+
+template<class T>
+void svm_solver<T>::set_racing(double fraction) {
+	this->race_fraction = std::max(0.0, fraction);
+}
+
+template<class T>
+void svm_solver<T>::set_early_exit(bool early_exit) {
+	this->early_exit = early_exit;
+}
+
+template<class T>
+constexpr double svm_solver<T>::EARLY_EXIT_RANGE;
+
 template class svm_solver<svm_model>;
 template class svm_solver<SVC>;
+template class svm_solver<dense_model>;
@@ -1,15 +1,39 @@
 #ifndef SVM_SOLVER_H
 #define SVM_SOLVER_H
 
+#include <cstdint>
 #include <vector>
 #include <utility>
 #include <memory>
+#include <functional>
 #include <svm.h>
 
 #include "svm_definitions.h"
 #include "data_structure/graph_access.h"
 #include "svm_summary.h"
 #include "svm_result.h"
+#include "svm_result_cache.h"
+
+// decision(x) = sum_k coef[k] * K(x, x_rows[k]) - rho, positive for the minority class
+struct svm_decision
+{
+	std::vector<int> rows;	// instance rows of the SVs
+	std::vector<double> coef;
+	double rho = 0;
+};
+
+// approximate training of large levels, see svm_solver::set_approximation
+struct svm_approximation
+{
+	enum KIND { NONE, RFF, NYSTROEM };
+
+	KIND kind = NONE;
+	size_t dimension = 512;	// random features
+	bool orthogonal = false;
+	uint64_t seed = 0;
+	// NYSTROEM: rows of the coarser level the kernel is approximated at
+	std::shared_ptr<const svm_data> landmarks;
+};
 
 template<class T>
 class svm_solver
@@ -19,6 +43,7 @@ public:
         svm_solver(const svm_instance & instance);
 
         virtual void train() = 0;
+        virtual std::unique_ptr<svm_solver<T>> clone() const = 0;
         svm_result<T> train_ud(const svm_data & min_sample, const svm_data & maj_sample);
         svm_result<T> train_grid(const svm_data & min_sample, const svm_data & maj_sample);
         svm_result<T> train_bayesopt(const svm_data & min_sample, const svm_data & maj_sample);
@@ -28,30 +53,120 @@ public:
 				  const svm_data & min_sample,
 				  const svm_data & maj_sample);
 
+	// trains up to candidates parameters concurrently, the summaries are in the order of params.
+	// Parameters that occur twice are trained once. With early_exit the scoring of a candidate
+	// stops once it can't get close to the best one of the batch (see train_single).
+	std::vector<svm_summary<T>> train_batch(const std::vector<svm_param> & params,
+						const svm_data & min_sample,
+						const svm_data & maj_sample,
+						int candidates,
+						bool early_exit = false);
+
+	// with an incumbent Gmean > 0 the validation data is scored in rounds and the summary
+	// is marked pruned (with the counts so far) once even the best case for the rest of it
+	// stays more than EARLY_EXIT_RANGE below the incumbent
 	svm_summary<T> train_single(svm_param,
 				    const svm_data & min_sample,
-				    const svm_data & maj_sample);
+				    const svm_data & maj_sample,
+				    double incumbent = 0);
 
 	virtual std::vector<int> predict_batch(const svm_data & data);
-        virtual int predict(const std::vector<svm_node> & node) = 0;
+	// predicts both validation sets, backends may do this in a single pass
+	virtual std::pair<std::vector<int>, std::vector<int>> predict_min_maj(const svm_data & min, const svm_data & maj);
+        virtual int predict(svm_row node) = 0;
 
 	virtual void export_to_file(const string & path) = 0;
 
 	virtual std::pair<std::vector<NodeID>, std::vector<NodeID>> get_SV() = 0;
+	virtual std::pair<std::vector<double>, std::vector<double>> get_SV_alpha() = 0;
+
+	// replaces the model by one with at most budget SVs (reduced-set merging),
+	// false if the backend does not support it
+	virtual bool compact(size_t budget);
+
+	// trains the next models on an explicit feature map of the rows with a linear
+	// solver instead of the kernel SVM, false if the backend does not support it
+	virtual bool set_approximation(const svm_approximation & approximation);
 
         svm_summary<T> build_summary(const svm_data & min, const svm_data & maj);
 
+	// true if the RBF decision function of every trained model can be read by
+	// get_decision, candidates of a sweep with the same gamma are then scored together
+	virtual bool fused_scoring() const;
+	virtual bool get_decision(svm_decision & decision);
+	// true if the backend computes the kernel of its predictions in double,
+	// fused scoring then does so as well so both give the same labels
+	virtual bool double_decision() const;
+
         void set_C(float C);
         void set_gamma(float gamma);
 	virtual void set_model(std::shared_ptr<T> new_model);
 	const svm_instance & get_instance();
 
+	// candidates: how many parameter candidates of a sweep are trained concurrently
+	// threads: threads used by a single candidate (0 = share the available cores)
+	void set_parallelism(int candidates, int threads);
+
+	// starting point of the next trainings, one alpha per instance row (empty = cold start)
+	void set_initial_alpha(std::vector<double> alpha);
+
+	// score the candidates of a sweep on a stratified slice (this fraction) of the
+	// validation data first and only the ones that may still beat the leader on all of it (0 = off)
+	void set_racing(double fraction);
+
+	// prune candidates of a sweep during scoring, see train_single
+	void set_early_exit(bool early_exit);
+
+	// same as the filter range of the summary comparators
+	static constexpr double EARLY_EXIT_RANGE = 0.02;
+
 protected:
         svm_result<T> make_result(const std::vector<svm_summary<T>> & vec);
 
+	// summary of the current model with the given confusion counts
+	svm_summary<T> make_summary(size_t tp, size_t tn, size_t fp, size_t fn);
+
+	// build_summary that stops early if the model can't come close to incumbent
+	svm_summary<T> score_early_exit(const svm_data & min_sample, const svm_data & maj_sample, double incumbent);
+
+	// summary of p from the cache, the solver is set to its model
+	bool from_cache(uint64_t data_key, svm_param p, svm_summary<T> & summary);
+
+	// sets the confusion counts of the pending slots, the validation data is
+	// scored once per gamma for all their models
+	void score_fused(std::vector<std::unique_ptr<svm_summary<T>>> & slots,
+			 const std::vector<svm_decision> & decisions,
+			 const std::vector<char> & pending,
+			 const svm_data & min_sample,
+			 const svm_data & maj_sample);
+
+	// runs run(solver, i) for every candidate i, up to candidates at once on clones
+	void for_candidates(size_t n, int candidates, const std::function<void(svm_solver<T> &, size_t)> & run);
+
+	// trains with 2^p.first, 2^p.second and returns the training time
+	double train_param(svm_param p);
+
+	void print_candidate(svm_param p, double train_time, svm_summary<T> & summary);
+
+	svm_result<T> race_range(const std::vector<svm_param> & params,
+				 const svm_data & min_sample,
+				 const svm_data & maj_sample);
+
         svm_parameter param;
         svm_instance instance;
 	std::shared_ptr<T> model;
+
+	int sweep_candidates = 1;
+	int sweep_threads = 0;
+
+	std::vector<double> initial_alpha;
+
+	double race_fraction = 0;
+
+	bool early_exit = false;
+
+	// shared with the clones, nullptr if disabled
+	std::shared_ptr<svm_result_cache<T>> result_cache;
 };
 
 #endif /* SVM_SOLVER_H */
@@ -0,0 +1,603 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <numeric>
+#include <random>
+
+#include "svm/svm_solver_dense.h"
+#include "svm/svm_compaction.h"
+#include "tools/timer.h"
+
+// least recently used cache of full kernel rows K(i, .)
+class kernel_row_cache
+{
+public:
+        kernel_row_cache(size_t l, size_t capacity)
+                : l(l), capacity(std::max<size_t>(2, std::min(l, capacity))),
+                  slot_of(l, NONE) {
+        }
+
+        // returns row i, missing is set if it still has to be computed
+        float * get(size_t i, bool & missing) {
+                size_t slot = this->slot_of[i];
+                if (slot != NONE) {
+                        this->lru.splice(this->lru.begin(), this->lru, this->position[slot]);
+                        missing = false;
+                        return this->rows[slot].get();
+                }
+
+                if (this->rows.size() < this->capacity) {
+                        slot = this->rows.size();
+                        this->rows.emplace_back(new float[this->l]);
+                        this->row_of.push_back(i);
+                        this->lru.push_front(slot);
+                        this->position.push_back(this->lru.begin());
+                } else {
+                        // the row used last stays at the front, so the pair of a step is never evicted
+                        slot = this->lru.back();
+                        this->slot_of[this->row_of[slot]] = NONE;
+                        this->row_of[slot] = i;
+                        this->lru.splice(this->lru.begin(), this->lru, this->position[slot]);
+                }
+
+                this->slot_of[i] = slot;
+                missing = true;
+                return this->rows[slot].get();
+        }
+
+private:
+        static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+        size_t l;
+        size_t capacity;
+        std::vector<size_t> slot_of;
+        std::vector<size_t> row_of;
+        std::vector<std::unique_ptr<float[]>> rows;
+        std::list<size_t> lru;
+        std::vector<std::list<size_t>::iterator> position;
+};
+
+// stopping tolerance of the linear solver on the projected gradient (as liblinear)
+static const double LINEAR_EPS = 0.1;
+static const int LINEAR_MAX_EPOCHS = 1000;
+
+static void kernel_row(const dense_matrix & M, size_t i, float gamma, float * out) {
+        const size_t block = 4096;
+        const float * x = M.row(i);
+
+        if (M.rows < 2 * block) {
+                dense_kernels::rbf_row(x, M.norms[i], M, 0, M.rows, gamma, out);
+                return;
+        }
+
+#pragma omp parallel for schedule(static)
+        for (size_t b = 0; b < M.rows; b += block) {
+                dense_kernels::rbf_row(x, M.norms[i], M, b, std::min(b + block, M.rows), gamma, out);
+        }
+}
+
+svm_solver_dense::svm_solver_dense(const svm_instance & instance)
+	: svm_solver(instance) {
+	this->data = std::make_shared<const dense_matrix>(
+		dense_matrix::from_nodes(this->instance.node_data(), this->instance.size()));
+}
+
+svm_solver_dense::svm_solver_dense() : svm_solver() {
+}
+
+std::unique_ptr<svm_solver<dense_model>> svm_solver_dense::clone() const {
+	return std::make_unique<svm_solver_dense>(*this);
+}
+
+void svm_solver_dense::train() {
+	const dense_matrix & X = *this->data;
+	size_t l = X.rows;
+
+	std::vector<signed char> y(l);
+	for (size_t i = 0; i < l; i++) {
+		y[i] = this->instance.labels->at(i) > 0 ? +1 : -1;
+	}
+
+	if (this->approximation.kind != svm_approximation::NONE) {
+		train_approximate(y);
+		return;
+	}
+
+	std::vector<double> alpha(l, 0.0);
+	if (this->initial_alpha.size() == l) {
+		// clip into the box and rescale the larger class so that sum(y * alpha) = 0
+		double C = this->param.C;
+		double sum_p = 0, sum_n = 0;
+		for (size_t i = 0; i < l; i++) {
+			alpha[i] = std::min(std::max(this->initial_alpha[i], 0.0), C);
+			if (y[i] > 0) sum_p += alpha[i]; else sum_n += alpha[i];
+		}
+		double scale_p = sum_p > sum_n ? sum_n / sum_p : 1;
+		double scale_n = sum_n > sum_p ? sum_p / sum_n : 1;
+		for (size_t i = 0; i < l; i++) {
+			alpha[i] *= y[i] > 0 ? scale_p : scale_n;
+		}
+	}
+
+	double rho = 0;
+	solve(y, alpha, rho);
+
+	this->model = make_model(y, alpha, rho);
+}
+
+std::shared_ptr<dense_model> svm_solver_dense::make_model(const std::vector<signed char> & y,
+							  const std::vector<double> & alpha, double rho) const {
+	const dense_matrix & X = *this->data;
+
+	auto trained = std::make_shared<dense_model>();
+	trained->gamma = this->param.gamma;
+	trained->rho = rho;
+	trained->SV = dense_matrix(0, X.features);
+	for (size_t i = 0; i < X.rows; i++) {
+		if (alpha[i] > 0) {
+			trained->SV.append_row(X.row(i), X.norms[i]);
+			trained->coef.push_back(y[i] * alpha[i]);
+			trained->sv_indices.push_back(i);
+			if (y[i] > 0) {
+				trained->nSV_min++;
+			} else {
+				trained->nSV_maj++;
+			}
+		}
+	}
+	return trained;
+}
+
+void svm_solver_dense::train_approximate(const std::vector<signed char> & y) {
+	const dense_matrix & X = *this->data;
+	const size_t l = X.rows;
+
+	std::shared_ptr<const kernel_map> map;
+	if (this->approximation.kind == svm_approximation::NYSTROEM && this->approximation.landmarks
+	    && !this->approximation.landmarks->empty()) {
+		map = std::make_shared<nystroem_map>(
+			dense_matrix::from_data(*this->approximation.landmarks, X.features), this->param.gamma);
+	} else {
+		map = std::make_shared<rff_map>(
+			X.features, this->approximation.dimension, this->param.gamma,
+			this->approximation.seed, this->approximation.orthogonal);
+	}
+	dense_matrix Z = map->map_all(X);
+
+	// there is no equality constraint, the alphas of the coarser level only have to be in the box
+	std::vector<double> alpha(l, 0.0);
+	if (this->initial_alpha.size() == l) {
+		for (size_t i = 0; i < l; i++) {
+			alpha[i] = std::min(std::max(this->initial_alpha[i], 0.0), this->param.C);
+		}
+	}
+
+	std::vector<double> w;
+	double bias = 0;
+	solve_linear(Z, y, alpha, w, bias);
+
+	std::shared_ptr<dense_model> trained = make_model(y, alpha, -bias);
+	trained->map = map;
+	trained->w = map->fold(w);
+	this->model = trained;
+}
+
+void svm_solver_dense::solve_linear(const dense_matrix & Z, const std::vector<signed char> & y,
+				    std::vector<double> & alpha, std::vector<double> & w, double & bias) const {
+	const size_t l = Z.rows;
+	const size_t D = Z.features;
+	const double C = this->param.C;
+	const double INF = std::numeric_limits<double>::infinity();
+
+	// w = sum_i y_i alpha_i z_i, the constant feature adds 1 to every diagonal entry
+	w.assign(D, 0.0);
+	bias = 0;
+	std::vector<double> QD(l);
+	for (size_t i = 0; i < l; i++) {
+		QD[i] = Z.norms[i] + 1.0;
+		if (alpha[i] > 0) {
+			const float * z = Z.row(i);
+			double ya = y[i] * alpha[i];
+			for (size_t k = 0; k < D; k++) {
+				w[k] += ya * z[k];
+			}
+			bias += ya;
+		}
+	}
+
+	std::vector<size_t> order(l);
+	std::iota(order.begin(), order.end(), 0);
+	std::mt19937_64 rng(this->approximation.seed);
+
+	for (int epoch = 0; epoch < LINEAR_MAX_EPOCHS; epoch++) {
+		std::shuffle(order.begin(), order.end(), rng);
+
+		double PGmax = -INF;
+		double PGmin = INF;
+		for (size_t i : order) {
+			const float * z = Z.row(i);
+			double G = bias;
+			for (size_t k = 0; k < D; k++) {
+				G += w[k] * z[k];
+			}
+			G = y[i] * G - 1;
+
+			// projected gradient
+			double PG = G;
+			if (alpha[i] <= 0) {
+				PG = std::min(G, 0.0);
+			} else if (alpha[i] >= C) {
+				PG = std::max(G, 0.0);
+			}
+			PGmax = std::max(PGmax, PG);
+			PGmin = std::min(PGmin, PG);
+
+			if (std::fabs(PG) > 1e-12) {
+				double old_alpha = alpha[i];
+				alpha[i] = std::min(std::max(old_alpha - G / QD[i], 0.0), C);
+				double d = y[i] * (alpha[i] - old_alpha);
+				for (size_t k = 0; k < D; k++) {
+					w[k] += d * z[k];
+				}
+				bias += d;
+			}
+		}
+
+		if (PGmax - PGmin < LINEAR_EPS) {
+			break;
+		}
+	}
+}
+
+void svm_solver_dense::solve(const std::vector<signed char> & y, std::vector<double> & alpha, double & rho) const {
+	const dense_matrix & X = *this->data;
+	const size_t l = X.rows;
+	const double C = this->param.C;
+	const double eps = this->param.eps;
+	const float gamma = this->param.gamma;
+	const double TAU = 1e-12;
+	const double INF = std::numeric_limits<double>::infinity();
+
+	size_t cache_rows = static_cast<size_t>(this->param.cache_size * (1 << 20) / (sizeof(float) * l));
+	kernel_row_cache cache(l, cache_rows);
+
+	auto row = [&](size_t i) {
+		bool missing;
+		float * K = cache.get(i, missing);
+		if (missing) {
+			kernel_row(X, i, gamma, K);
+		}
+		return K;
+	};
+
+	// gradient of 0.5 a^T Q a - e^T a with Q_ij = y_i y_j K_ij
+	std::vector<double> G(l, -1.0);
+	for (size_t i = 0; i < l; i++) {
+		if (alpha[i] > 0) {
+			const float * K_i = row(i);
+			double ya = y[i] * alpha[i];
+			for (size_t t = 0; t < l; t++) {
+				G[t] += y[t] * ya * K_i[t];
+			}
+		}
+	}
+
+	long max_iter = std::max<long>(10000000, 100 * static_cast<long>(l));
+	for (long iter = 0; iter < max_iter; iter++) {
+		// i maximizes -y_t G_t over I_up
+		double Gmax = -INF;
+		long i = -1;
+		for (size_t t = 0; t < l; t++) {
+			if (y[t] > 0 ? alpha[t] < C : alpha[t] > 0) {
+				double v = -y[t] * G[t];
+				if (v >= Gmax) {
+					Gmax = v;
+					i = t;
+				}
+			}
+		}
+		if (i == -1) {
+			break;
+		}
+
+		// j minimizes the second order approximation of the objective over I_low
+		const float * K_i = row(i);
+		double Gmax2 = -INF;
+		double obj_min = INF;
+		long j = -1;
+		for (size_t t = 0; t < l; t++) {
+			if (y[t] > 0 ? alpha[t] > 0 : alpha[t] < C) {
+				double v = y[t] * G[t];
+				Gmax2 = std::max(Gmax2, v);
+				double grad_diff = Gmax + v;
+				if (grad_diff > 0) {
+					double quad = 2.0 - 2.0 * K_i[t];
+					double obj = -(grad_diff * grad_diff) / (quad > 0 ? quad : TAU);
+					if (obj <= obj_min) {
+						obj_min = obj;
+						j = t;
+					}
+				}
+			}
+		}
+		if (Gmax + Gmax2 < eps || j == -1) {
+			break;
+		}
+
+		const float * K_j = row(j);
+		double old_ai = alpha[i];
+		double old_aj = alpha[j];
+		double quad = std::max(2.0 - 2.0 * K_i[j], TAU);
+
+		if (y[i] != y[j]) {
+			double delta = (-G[i] - G[j]) / quad;
+			double diff = alpha[i] - alpha[j];
+			alpha[i] += delta;
+			alpha[j] += delta;
+			if (diff > 0) {
+				if (alpha[j] < 0) { alpha[j] = 0; alpha[i] = diff; }
+			} else {
+				if (alpha[i] < 0) { alpha[i] = 0; alpha[j] = -diff; }
+			}
+			if (diff > 0) {
+				if (alpha[i] > C) { alpha[i] = C; alpha[j] = C - diff; }
+			} else {
+				if (alpha[j] > C) { alpha[j] = C; alpha[i] = C + diff; }
+			}
+		} else {
+			double delta = (G[i] - G[j]) / quad;
+			double sum = alpha[i] + alpha[j];
+			alpha[i] -= delta;
+			alpha[j] += delta;
+			if (sum > C) {
+				if (alpha[i] > C) { alpha[i] = C; alpha[j] = sum - C; }
+				if (alpha[j] > C) { alpha[j] = C; alpha[i] = sum - C; }
+			} else {
+				if (alpha[j] < 0) { alpha[j] = 0; alpha[i] = sum; }
+				if (alpha[i] < 0) { alpha[i] = 0; alpha[j] = sum; }
+			}
+		}
+
+		double d_i = y[i] * (alpha[i] - old_ai);
+		double d_j = y[j] * (alpha[j] - old_aj);
+		for (size_t t = 0; t < l; t++) {
+			G[t] += y[t] * (d_i * K_i[t] + d_j * K_j[t]);
+		}
+	}
+
+	// rho as in libsvm: average over free SVs, midpoint of the bounds otherwise
+	double ub = INF, lb = -INF, sum_free = 0;
+	size_t nr_free = 0;
+	for (size_t t = 0; t < l; t++) {
+		double yG = y[t] * G[t];
+		if (alpha[t] >= C) {
+			if (y[t] < 0) ub = std::min(ub, yG); else lb = std::max(lb, yG);
+		} else if (alpha[t] <= 0) {
+			if (y[t] > 0) ub = std::min(ub, yG); else lb = std::max(lb, yG);
+		} else {
+			nr_free++;
+			sum_free += yG;
+		}
+	}
+	rho = nr_free > 0 ? sum_free / nr_free : (ub + lb) / 2;
+}
+
+double svm_solver_dense::decision_value(const float * x, float x_norm, float * buf) const {
+	const dense_model & m = *this->model;
+	if (m.map) {
+		m.map->score_features(x, x_norm, buf);
+		double sum = 0;
+		for (size_t k = 0; k < m.w.size(); k++) {
+			sum += m.w[k] * buf[k];
+		}
+		return sum - m.rho;
+	}
+
+	dense_kernels::rbf_row(x, x_norm, m.SV, 0, m.SV.rows, m.gamma, buf);
+	double sum = 0;
+	for (size_t i = 0; i < m.SV.rows; i++) {
+		sum += m.coef[i] * buf[i];
+	}
+	return sum - m.rho;
+}
+
+int svm_solver_dense::predict(svm_row nodes) {
+	const dense_matrix & SV = this->model->SV;
+	thread_local std::vector<float> x;
+	thread_local std::vector<float> buf;
+	x.resize(SV.stride);
+	buf.resize(this->model->map ? this->model->w.size() : SV.rows);
+
+	float x_norm = dense_matrix::fill_row(nodes.data(), SV.features, SV.stride, x.data());
+	return decision_value(x.data(), x_norm, buf.data()) > 0 ? 1 : -1;
+}
+
+std::vector<int> svm_solver_dense::predict_batch(const svm_data & data) {
+	return predict_dense({ &data });
+}
+
+std::pair<std::vector<int>, std::vector<int>> svm_solver_dense::predict_min_maj(const svm_data & min, const svm_data & maj) {
+	std::vector<int> both = predict_dense({ &min, &maj });
+	std::vector<int> maj_result(both.begin() + min.size(), both.end());
+	both.resize(min.size());
+	return std::make_pair(both, maj_result);
+}
+
+std::vector<int> svm_solver_dense::predict_dense(const std::vector<const svm_data*> & parts) const {
+	const dense_model & m = *this->model;
+
+	size_t total = 0;
+	for (const svm_data * part : parts) {
+		total += part->size();
+	}
+	dense_matrix X(total, m.SV.features);
+	for (const svm_data * part : parts) {
+		X.append_data(*part);
+	}
+
+	std::vector<double> dec(X.rows);
+	if (m.map) {
+#pragma omp parallel
+		{
+			std::vector<float> z(m.w.size());
+#pragma omp for schedule(static)
+			for (size_t i = 0; i < X.rows; i++) {
+				dec[i] = decision_value(X.row(i), X.norms[i], z.data());
+			}
+		}
+	} else {
+		dense_kernels::rbf_decision(X, m.SV, m.coef.data(), m.rho, m.gamma, dec.data());
+	}
+
+	std::vector<int> result(X.rows);
+	for (size_t i = 0; i < X.rows; i++) {
+		result[i] = dec[i] > 0 ? 1 : -1;
+	}
+	return result;
+}
+
+void svm_solver_dense::export_to_file(const string & path) {
+	// libsvm model format, so the model can be loaded with svm_load_model
+	const dense_model & m = *this->model;
+	const dense_matrix * SV = &m.SV;
+	const std::vector<double> * coef = &m.coef;
+	std::vector<size_t> order(SV->rows);
+	std::iota(order.begin(), order.end(), 0);
+	size_t nSV_min = m.nSV_min;
+
+	if (m.map) {
+		// a Nystroem model is the exact RBF expansion fold(w) over the landmarks,
+		// the alphas on the mapped rows (SV / coef) would predict something else
+		SV = m.map->kernel_centers();
+		if (SV == nullptr) {
+			std::cout << "random feature models can't be exported, " << path << " not written" << std::endl;
+			return;
+		}
+		coef = &m.w;
+		order.resize(SV->rows);
+		std::iota(order.begin(), order.end(), 0);
+		// libsvm groups the SVs by class, the positive coefficients come first
+		auto first_maj = std::stable_partition(order.begin(), order.end(), [&](size_t i) { return m.w[i] > 0; });
+		nSV_min = first_maj - order.begin();
+	}
+
+	FILE * fp = fopen(path.c_str(), "w");
+	if (fp == NULL) {
+		std::cerr << "Error opening file " << path << std::endl;
+		return;
+	}
+
+	fprintf(fp, "svm_type c_svc\n");
+	fprintf(fp, "kernel_type rbf\n");
+	fprintf(fp, "gamma %.17g\n", m.gamma);
+	fprintf(fp, "nr_class 2\n");
+	fprintf(fp, "total_sv %zu\n", SV->rows);
+	fprintf(fp, "rho %.17g\n", m.rho);
+	fprintf(fp, "label 1 -1\n");
+	fprintf(fp, "nr_sv %zu %zu\n", nSV_min, SV->rows - nSV_min);
+	fprintf(fp, "SV\n");
+	for (size_t i : order) {
+		fprintf(fp, "%.17g ", (*coef)[i]);
+		const float * sv = SV->row(i);
+		for (size_t k = 0; k < SV->features; k++) {
+			if (sv[k] != 0) {
+				fprintf(fp, "%zu:%.8g ", k + 1, sv[k]);
+			}
+		}
+		fprintf(fp, "\n");
+	}
+
+	// fprintf errors stick to the stream, fclose reports the ones of the last flush
+	bool failed = ferror(fp) != 0;
+	if (fclose(fp) != 0 || failed) {
+		std::cerr << "Error writing file " << path << std::endl;
+	}
+}
+
+bool svm_solver_dense::compact(size_t budget) {
+	// a new model, summaries may still hold the current one
+	auto compacted = std::make_shared<dense_model>(*this->model);
+
+	if (this->model->map) {
+		// SV / coef of an approximate model are the rows of the linear dual, not its
+		// decision function. A Nystroem model is the RBF expansion w over the landmarks,
+		// random features have none
+		const dense_matrix * centers = this->model->map->kernel_centers();
+		if (centers == nullptr) {
+			return false;
+		}
+		compacted->SV = *centers;
+		compacted->coef = this->model->w;
+		compacted->sv_indices.assign(centers->rows, -1);
+	}
+
+	// the merged SVs are scored with the kernel
+	compacted->map.reset();
+	compacted->w.clear();
+	compacted->compacted = true;
+
+	svm_compaction::merge(compacted->SV, compacted->coef, compacted->sv_indices, compacted->gamma, budget);
+	compacted->nSV_min = svm_compaction::group_by_class(compacted->SV, compacted->coef, compacted->sv_indices);
+	compacted->nSV_maj = compacted->SV.rows - compacted->nSV_min;
+
+	this->model = compacted;
+	return true;
+}
+
+std::pair<std::vector<NodeID>, std::vector<NodeID>> svm_solver_dense::get_SV() {
+	std::vector<NodeID> SV_min;
+	std::vector<NodeID> SV_maj;
+	SV_min.reserve(this->model->nSV_min);
+	SV_maj.reserve(this->model->nSV_maj);
+
+	// the SVs are grouped by class, the minority ones first
+	for (size_t i = 0; i < this->model->sv_indices.size(); i++) {
+		int index = this->model->sv_indices[i];
+		if (i < static_cast<size_t>(this->model->nSV_min)) {
+			SV_min.push_back(index);
+		} else {
+			SV_maj.push_back(index - instance.num_min);
+		}
+	}
+
+	return std::make_pair(SV_min, SV_maj);
+}
+
+bool svm_solver_dense::set_approximation(const svm_approximation & approximation) {
+	this->approximation = approximation;
+	return true;
+}
+
+bool svm_solver_dense::fused_scoring() const {
+	return true;
+}
+
+bool svm_solver_dense::get_decision(svm_decision & decision) {
+	if (!this->model || this->model->map || this->model->compacted) {
+		return false;
+	}
+	decision.rows = this->model->sv_indices;
+	decision.coef = this->model->coef;
+	decision.rho = this->model->rho;
+	return true;
+}
+
+std::pair<std::vector<double>, std::vector<double>> svm_solver_dense::get_SV_alpha() {
+	std::vector<double> alpha_min;
+	std::vector<double> alpha_maj;
+	alpha_min.reserve(this->model->nSV_min);
+	alpha_maj.reserve(this->model->nSV_maj);
+
+	for (size_t i = 0; i < this->model->coef.size(); i++) {
+		if (this->model->coef[i] > 0) {
+			alpha_min.push_back(this->model->coef[i]);
+		} else {
+			alpha_maj.push_back(-this->model->coef[i]);
+		}
+	}
+
+	return std::make_pair(alpha_min, alpha_maj);
+}
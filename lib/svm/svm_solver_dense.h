@@ -0,0 +1,57 @@
+#ifndef SVM_SOLVER_DENSE_H
+#define SVM_SOLVER_DENSE_H
+
+#include <memory>
+#include <utility>
+
+#include "svm_solver.h"
+#include "dense_model.h"
+
+// C-SVC with RBF kernel on a contiguous float copy of the instance.
+// SMO with second order working set selection (as libsvm, without shrinking),
+// kernel rows are computed by the SIMD kernels and kept in an LRU cache.
+// With set_approximation the rows are mapped by a kernel_map and a linear SVM
+// is trained on them by dual coordinate descent instead.
+class svm_solver_dense : public svm_solver<dense_model>
+{
+public:
+	svm_solver_dense();
+        svm_solver_dense(const svm_instance & instance);
+
+        void train() override;
+        std::unique_ptr<svm_solver<dense_model>> clone() const override;
+        int predict(svm_row node) override;
+	std::vector<int> predict_batch(const svm_data & data) override;
+	std::pair<std::vector<int>, std::vector<int>> predict_min_maj(const svm_data & min, const svm_data & maj) override;
+	void export_to_file(const string & path) override;
+	std::pair<std::vector<NodeID>, std::vector<NodeID>> get_SV() override;
+	std::pair<std::vector<double>, std::vector<double>> get_SV_alpha() override;
+	bool compact(size_t budget) override;
+	bool set_approximation(const svm_approximation & approximation) override;
+	bool fused_scoring() const override;
+	bool get_decision(svm_decision & decision) override;
+
+private:
+	double decision_value(const float * x, float x_norm, float * buf) const;
+	std::vector<int> predict_dense(const std::vector<const svm_data*> & parts) const;
+
+	void solve(const std::vector<signed char> & y, std::vector<double> & alpha, double & rho) const;
+
+	// dual coordinate descent for the L1-loss linear SVM on the mapped rows Z,
+	// the bias is learned as the weight of a constant feature 1
+	void solve_linear(const dense_matrix & Z, const std::vector<signed char> & y,
+			  std::vector<double> & alpha, std::vector<double> & w, double & bias) const;
+
+	void train_approximate(const std::vector<signed char> & y);
+
+	// model with the rows with alpha > 0 as SVs
+	std::shared_ptr<dense_model> make_model(const std::vector<signed char> & y,
+						const std::vector<double> & alpha, double rho) const;
+
+	// shared by all clones, the instance does not change
+	std::shared_ptr<const dense_matrix> data;
+
+	svm_approximation approximation;
+};
+
+#endif /* SVM_SOLVER_DENSE_H */
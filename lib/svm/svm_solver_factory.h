@@ -8,6 +8,7 @@
 #include "svm/svm_solver.h"
 #include "svm/svm_solver_libsvm.h"
 #include "svm/svm_solver_thunder.h"
+#include "svm/svm_solver_dense.h"
 #include "svm/svm_instance.h"
 
 class svm_solver_factory {
@@ -26,4 +27,9 @@ std::unique_ptr<svm_solver<SVC>> svm_solver_factory::create(const svm_instance &
 	return std::make_unique<svm_solver_thunder>(instance);
 }
 
+template<> inline
+std::unique_ptr<svm_solver<dense_model>> svm_solver_factory::create(const svm_instance & instance) {
+	return std::make_unique<svm_solver_dense>(instance);
+}
+
 #endif /* SVM_SOLVER_FACTORY_H */
@@ -1,9 +1,12 @@
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <functional>
 
 #include "svm/param_search.h"
 #include "svm/svm_solver_libsvm.h"
 #include "svm/svm_convert.h"
+#include "svm/svm_compaction.h"
 #include "tools/timer.h"
 
 svm_solver_libsvm::svm_solver_libsvm(const svm_instance & instance)
@@ -13,12 +16,26 @@ svm_solver_libsvm::svm_solver_libsvm(const svm_instance & instance)
 svm_solver_libsvm::svm_solver_libsvm() : svm_solver() {
 }
 
+std::unique_ptr<svm_solver<svm_model>> svm_solver_libsvm::clone() const {
+	return std::make_unique<svm_solver_libsvm>(*this);
+}
+
 void svm_solver_libsvm::train() {
         svm_problem prob;
         prob.l = this->instance.size();
         prob.y = this->instance.label_data();
         prob.x = this->instance.node_data();
 
+        // all candidates of a sweep share the squared distances of the instance
+        std::shared_ptr<svm_distance_cache> distances;
+        const svm_sq_dist * sq_dist = NULL;
+        if (this->param.kernel_type == RBF) {
+                distances = this->instance.distances();
+        }
+        if (distances != nullptr) {
+                sq_dist = distances->libsvm_source();
+        }
+
         const char * error_msg = svm_check_parameter(&prob, &(this->param));
         if (error_msg != NULL) {
                 std::cout << error_msg << std::endl;
@@ -26,16 +43,162 @@ void svm_solver_libsvm::train() {
                 exit(0);
         }
 
-        svm_model * trained_model = svm_train(&prob, &(this->param));
+        const double * init_alpha = NULL;
+        if (this->initial_alpha.size() == static_cast<size_t>(prob.l)) {
+                init_alpha = this->initial_alpha.data();
+        }
+
+        svm_model * trained_model;
+        if (sq_dist != NULL) {
+                prob.x = distances->proxy_data();
+                trained_model = svm_train_dist(&prob, &(this->param), init_alpha, sq_dist);
+
+                // point the SVs back to the real rows so the model can predict and be saved
+                svm_node ** nodes = this->instance.node_data();
+                for (int i = 0; i < trained_model->l; i++) {
+                        trained_model->SV[i] = nodes[trained_model->sv_indices[i] - 1];
+                }
+        } else {
+                trained_model = svm_train_warm(&prob, &(this->param), init_alpha);
+        }
 
         this->model = std::shared_ptr<svm_model>
             (trained_model, [](svm_model* m) { svm_free_and_destroy_model(&m); });
 }
 
-int svm_solver_libsvm::predict(const std::vector<svm_node> & nodes) {
+int svm_solver_libsvm::predict(svm_row nodes) {
         return svm_predict(this->model.get(), nodes.data());
 }
 
+std::vector<int> svm_solver_libsvm::predict_batch(const svm_data & data) {
+	if (!dense_predictable()) {
+		return svm_solver::predict_batch(data);
+	}
+	return predict_dense({ &data });
+}
+
+std::pair<std::vector<int>, std::vector<int>> svm_solver_libsvm::predict_min_maj(const svm_data & min, const svm_data & maj) {
+	if (!dense_predictable()) {
+		return svm_solver::predict_min_maj(min, maj);
+	}
+
+	// score both sets in one pass over the SVs
+	std::vector<int> both = predict_dense({ &min, &maj });
+	std::vector<int> maj_result(both.begin() + min.size(), both.end());
+	both.resize(min.size());
+	return std::make_pair(both, maj_result);
+}
+
+bool svm_solver_libsvm::dense_predictable() const {
+	return this->model
+		&& this->model->param.svm_type == C_SVC
+		&& this->model->param.kernel_type == RBF
+		&& this->model->nr_class == 2;
+}
+
+std::vector<int> svm_solver_libsvm::predict_dense(const std::vector<const svm_data*> & parts) {
+	std::shared_ptr<const dense_svs> svs = get_dense_svs();
+	const svm_model * m = svs->source.get();
+
+	size_t total = 0;
+	for (const svm_data * part : parts) {
+		total += part->size();
+	}
+	dense_matrix_double X(total, svs->SV.features);
+	for (const svm_data * part : parts) {
+		X.append_data(*part);
+	}
+
+	std::vector<double> dec(X.rows);
+	dense_kernels::rbf_decision(X, svs->SV, m->sv_coef[0], m->rho[0], m->param.gamma, dec.data());
+
+	// same rule as svm_predict: a positive decision value votes for the first label
+	std::vector<int> result(X.rows);
+	for (size_t i = 0; i < X.rows; i++) {
+		result[i] = dec[i] > 0 ? m->label[0] : m->label[1];
+	}
+	return result;
+}
+
+std::shared_ptr<const svm_solver_libsvm::dense_svs> svm_solver_libsvm::get_dense_svs() {
+	std::shared_ptr<const dense_svs> cached = std::atomic_load(&this->predict_cache);
+	if (cached && cached->source == this->model) {
+		return cached;
+	}
+
+	// concurrent callers may build it twice, both results are equal
+	auto svs = std::make_shared<dense_svs>();
+	svs->source = this->model;
+	svs->SV = dense_matrix_double::from_nodes(this->model->SV, this->model->l);
+
+	std::atomic_store(&this->predict_cache, std::shared_ptr<const dense_svs>(svs));
+	return svs;
+}
+
+
+bool svm_solver_libsvm::compact(size_t budget) {
+	if (!dense_predictable()) {
+		return false;
+	}
+
+	const svm_model * m = this->model.get();
+	dense_matrix SV = dense_matrix::from_nodes(m->SV, m->l);
+	std::vector<double> coef(m->sv_coef[0], m->sv_coef[0] + m->l);
+	std::vector<int> index(m->sv_indices, m->sv_indices + m->l);
+
+	svm_compaction::merge(SV, coef, index, m->param.gamma, budget);
+	size_t n_first = svm_compaction::group_by_class(SV, coef, index);
+
+	// the merged SVs are no rows of the instance, so the model owns its nodes
+	// in the layout of svm_load_model and svm_free_and_destroy_model releases them
+	size_t elements = 0;
+	for (size_t i = 0; i < SV.rows; i++) {
+		const float * row = SV.row(i);
+		elements += std::count_if(row, row + SV.features, [](float v) { return v != 0; }) + 1;
+	}
+
+	svm_model * compacted = (svm_model *) malloc(sizeof(svm_model));
+	compacted->param = m->param;
+	compacted->nr_class = 2;
+	compacted->l = SV.rows;
+	compacted->SV = (svm_node **) malloc(SV.rows * sizeof(svm_node *));
+	compacted->sv_coef = (double **) malloc(sizeof(double *));
+	compacted->sv_coef[0] = (double *) malloc(SV.rows * sizeof(double));
+	compacted->rho = (double *) malloc(sizeof(double));
+	compacted->rho[0] = m->rho[0];
+	compacted->probA = NULL;
+	compacted->probB = NULL;
+	compacted->sv_indices = (int *) malloc(SV.rows * sizeof(int));
+	compacted->label = (int *) malloc(2 * sizeof(int));
+	compacted->label[0] = m->label[0];
+	compacted->label[1] = m->label[1];
+	compacted->nSV = (int *) malloc(2 * sizeof(int));
+	compacted->nSV[0] = n_first;
+	compacted->nSV[1] = SV.rows - n_first;
+	compacted->free_sv = 1;
+
+	svm_node * x_space = (svm_node *) malloc(elements * sizeof(svm_node));
+	for (size_t i = 0; i < SV.rows; i++) {
+		compacted->SV[i] = x_space;
+		compacted->sv_coef[0][i] = coef[i];
+		compacted->sv_indices[i] = index[i];
+
+		const float * row = SV.row(i);
+		for (size_t k = 0; k < SV.features; k++) {
+			if (row[k] != 0) {
+				x_space->index = k + 1;
+				x_space->value = row[k];
+				x_space++;
+			}
+		}
+		x_space->index = -1;
+		x_space++;
+	}
+
+	this->model = std::shared_ptr<svm_model>
+	    (compacted, [](svm_model* m) { svm_free_and_destroy_model(&m); });
+	return true;
+}
 
 void svm_solver_libsvm::export_to_file(const string & path) {
 	int ret = svm_save_model(path.c_str(), this->model.get());
@@ -60,3 +223,46 @@ std::pair<std::vector<NodeID>, std::vector<NodeID>> svm_solver_libsvm::get_SV()
 
 	return std::make_pair(SV_min, SV_maj);
 }
+
+bool svm_solver_libsvm::fused_scoring() const {
+	return this->param.svm_type == C_SVC && this->param.kernel_type == RBF;
+}
+
+bool svm_solver_libsvm::double_decision() const {
+	return true;
+}
+
+bool svm_solver_libsvm::get_decision(svm_decision & decision) {
+	if (!dense_predictable() || this->model->sv_indices == nullptr) {
+		return false;
+	}
+
+	// a positive decision value votes for label[0], flip it if that is the majority
+	double sign = this->model->label[0] == 1 ? 1 : -1;
+
+	decision.rows.resize(this->model->l);
+	decision.coef.resize(this->model->l);
+	for (int i = 0; i < this->model->l; i++) {
+		decision.rows[i] = this->model->sv_indices[i] - 1;
+		decision.coef[i] = sign * this->model->sv_coef[0][i];
+	}
+	decision.rho = sign * this->model->rho[0];
+	return true;
+}
+
+std::pair<std::vector<double>, std::vector<double>> svm_solver_libsvm::get_SV_alpha() {
+	// sv_coef holds y * alpha in the same order as sv_indices
+	std::vector<double> alpha_min;
+	alpha_min.reserve(model->nSV[0]);
+        for(int i = 0; i < model->nSV[0]; i++) {
+                alpha_min.push_back(std::fabs(model->sv_coef[0][i]));
+        }
+
+	std::vector<double> alpha_maj;
+	alpha_maj.reserve(model->nSV[1]);
+        for(int i = 0; i < model->nSV[1]; i++) {
+                alpha_maj.push_back(std::fabs(model->sv_coef[0][model->nSV[0] + i]));
+        }
+
+	return std::make_pair(alpha_min, alpha_maj);
+}
@@ -5,6 +5,7 @@
 #include <svm.h>
 
 #include "svm_solver.h"
+#include "dense_kernels.h"
 
 class svm_solver_libsvm : public svm_solver<svm_model>
 {
@@ -13,9 +14,33 @@ public:
         svm_solver_libsvm(const svm_instance & instance);
 
         void train() override;
-        int predict(const std::vector<svm_node> & node) override;
+        std::unique_ptr<svm_solver<svm_model>> clone() const override;
+        int predict(svm_row node) override;
+	std::vector<int> predict_batch(const svm_data & data) override;
+	std::pair<std::vector<int>, std::vector<int>> predict_min_maj(const svm_data & min, const svm_data & maj) override;
 	void export_to_file(const string & path) override;
 	std::pair<std::vector<NodeID>, std::vector<NodeID>> get_SV() override;
+	std::pair<std::vector<double>, std::vector<double>> get_SV_alpha() override;
+	bool compact(size_t budget) override;
+	bool fused_scoring() const override;
+	bool get_decision(svm_decision & decision) override;
+	bool double_decision() const override;
+
+private:
+	// binary RBF models are predicted on a dense copy of the SVs, in double
+	// as svm_predict so both give the same labels
+	bool dense_predictable() const;
+	std::vector<int> predict_dense(const std::vector<const svm_data*> & parts);
+
+	struct dense_svs {
+		std::shared_ptr<svm_model> source;
+		dense_matrix_double SV;
+	};
+
+	std::shared_ptr<const dense_svs> get_dense_svs();
+
+	// rebuilt whenever the model changes, shared by concurrent predict calls
+	std::shared_ptr<const dense_svs> predict_cache;
 };
 
 #endif /* SVM_SOLVER_LIBSVM_H */
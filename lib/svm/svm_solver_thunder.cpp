@@ -1,11 +1,64 @@
 #include <algorithm>
+#include <cmath>
 #include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
 
 #include "svm/param_search.h"
 #include "svm/svm_solver_thunder.h"
 #include "svm/svm_convert.h"
 #include "tools/timer.h"
 
+namespace {
+
+// validation/test sets of the current fold, min and maj each
+const size_t CONVERTED_SETS = 4;
+
+// share of the available memory the kernel rows of a predict batch may use
+const size_t PREDICT_MEMORY_SHARE = 4;
+
+// thundersvm copy of an evaluation set, every candidate and level of a fold
+// scores the same sets so they are converted once and kept by svm_data::id
+std::shared_ptr<const DataSet::node2d> converted_set(const svm_data & data) {
+	static std::mutex mutex;
+	static std::list<std::pair<uint64_t, std::shared_ptr<const DataSet::node2d>>> sets;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto it = sets.begin(); it != sets.end(); ++it) {
+			if (it->first == data.id()) {
+				sets.splice(sets.begin(), sets, it);
+				return it->second;
+			}
+		}
+	}
+
+	// concurrent callers may convert the same set twice, both results are equal
+	auto nodes = std::make_shared<const DataSet::node2d>(svm_convert::svmdata_to_dataset(data));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	sets.emplace_front(data.id(), nodes);
+	if (sets.size() > CONVERTED_SETS) {
+		sets.pop_back();
+	}
+	return nodes;
+}
+
+// thundersvm computes a batch x SVs kernel block per batch
+int predict_batch_size(size_t samples, size_t svs) {
+	long pages = sysconf(_SC_AVPHYS_PAGES);
+	long page_size = sysconf(_SC_PAGESIZE);
+	size_t available = pages > 0 && page_size > 0 ? (size_t) pages * page_size : (size_t) 1 << 30;
+
+	size_t per_sample = std::max<size_t>(svs, 1) * sizeof(float_type);
+	size_t batch = available / PREDICT_MEMORY_SHARE / per_sample;
+	return (int) std::max<size_t>(1, std::min(batch, std::max<size_t>(samples, 1)));
+}
+
+}
+
 svm_solver_thunder::svm_solver_thunder(const svm_instance & instance)
 	: svm_solver(instance) {
 }
@@ -13,6 +66,10 @@ svm_solver_thunder::svm_solver_thunder(const svm_instance & instance)
 svm_solver_thunder::svm_solver_thunder() : svm_solver() {
 }
 
+std::unique_ptr<svm_solver<SVC>> svm_solver_thunder::clone() const {
+	return std::make_unique<svm_solver_thunder>(*this);
+}
+
 void svm_solver_thunder::train() {
 	this->model = std::shared_ptr<SVC>(new SVC());
 	SvmParam param;
@@ -32,31 +89,81 @@ void svm_solver_thunder::train() {
 	param.max_mem_size = this->param.cache_size * (1 << 20); //MB to Byte
 	// param.max_mem_size = -1; // no limit
 
-	DataSet::node2d nodes = instance.node_data_thunder();
-	DataSet dataset(nodes, this->instance.features, *this->instance.labels);
-	model->train(dataset, param);
+	// SVC::train always starts SMO from alpha = 0, so initial_alpha can not be used here
+
+	std::shared_ptr<const DataSet> dataset = this->instance.dataset_thunder();
+	model->train(*dataset, param);
 }
 
 
 std::vector<int> svm_solver_thunder::predict_batch(const svm_data & data) {
-	DataSet::node2d dataset = svm_convert::svmdata_to_dataset(data);
-	//TODO don't use fixed batch size
-	std::vector<double> dRes = this->model->predict(dataset, -1); //define batch size
+	std::shared_ptr<const DataSet::node2d> dataset = converted_set(data);
+	int batch_size = predict_batch_size(dataset->size(), this->model->total_sv());
+	std::vector<double> dRes = this->model->predict(*dataset, batch_size);
 	std::vector<int> iRes(dRes.begin(), dRes.end());
 	return iRes;
 }
 
-int svm_solver_thunder::predict(const std::vector<svm_node> & nodes) {
-	//TODO doesn't work but predict_batch is used anyway
-	exit(1);
-	DataSet::node2d dataset(1);
-	dataset[0].reserve(nodes.size());
-	for (size_t i = 0; i < nodes.size() - 1; i++) {
-		svm_node n = nodes[i];
-		dataset[0][i] = DataSet::node(n.index, n.value);
+int svm_solver_thunder::predict(svm_row nodes) {
+	// SVC::predict sets up the batch machinery for every call, so one sample
+	// is scored directly against the dense SVs
+	std::shared_ptr<const dense_svs> svs = get_dense_svs();
+	const dense_matrix & SV = svs->SV;
+
+	thread_local std::vector<float> x;
+	thread_local std::vector<float> K;
+	x.resize(SV.stride);
+	K.resize(SV.rows);
+
+	float x_norm = dense_matrix::fill_row(nodes.data(), SV.features, SV.stride, x.data());
+	dense_kernels::rbf_row(x.data(), x_norm, SV, 0, SV.rows, svs->gamma, K.data());
+
+	double dec = -svs->rho;
+	for (size_t i = 0; i < SV.rows; i++) {
+		dec += svs->coef[i] * K[i];
 	}
-	double res = this->model->predict(dataset, 50).front();
-        return static_cast<int>(res);
+
+	// thundersvm orders the labels by their first occurence, the minority (+1) comes first
+        return dec > 0 ? 1 : -1;
+}
+
+std::shared_ptr<const svm_solver_thunder::dense_svs> svm_solver_thunder::get_dense_svs() {
+	std::shared_ptr<const dense_svs> cached = std::atomic_load(&this->predict_cache);
+	if (cached && cached->source == this->model) {
+		return cached;
+	}
+
+	// concurrent callers may build it twice, both results are equal
+	auto svs = std::make_shared<dense_svs>();
+	svs->source = this->model;
+	svs->rho = this->model->get_rho().host_data()[0];
+	svs->gamma = this->model->get_param().gamma;
+
+	const DataSet::node2d & nodes = this->model->svs();
+	size_t features = 0;
+	for (const auto & sv : nodes) {
+		for (const auto & node : sv) {
+			features = std::max(features, static_cast<size_t>(node.index));
+		}
+	}
+
+	svs->SV = dense_matrix(nodes.size(), features);
+	std::vector<float> row(svs->SV.stride);
+	for (const auto & sv : nodes) {
+		std::fill(row.begin(), row.end(), 0.0f);
+		double norm = 0;
+		for (const auto & node : sv) {
+			row[node.index - 1] = node.value;
+			norm += node.value * node.value;
+		}
+		svs->SV.append_row(row.data(), norm);
+	}
+
+	const float_type * coef = this->model->get_coef().host_data();
+	svs->coef.assign(coef, coef + nodes.size());
+
+	std::atomic_store(&this->predict_cache, std::shared_ptr<const dense_svs>(svs));
+	return svs;
 }
 
 
@@ -82,3 +189,22 @@ std::pair<std::vector<NodeID>, std::vector<NodeID>> svm_solver_thunder::get_SV()
 
 	return std::make_pair(SV_min, SV_maj);
 }
+
+std::pair<std::vector<double>, std::vector<double>> svm_solver_thunder::get_SV_alpha() {
+	const std::vector<int> SV_ind = this->model->get_sv_ind();
+	const float_type * coef = this->model->get_coef().host_data();
+	std::vector<double> alpha_min;
+	std::vector<double> alpha_maj;
+
+        for (size_t i = 0; i < SV_ind.size(); i++) {
+		double alpha = std::fabs(coef[i]);
+
+                if (static_cast<NodeID>(SV_ind[i]) < instance.num_min) {
+			alpha_min.push_back(alpha);
+		} else {
+			alpha_maj.push_back(alpha);
+		}
+        }
+
+	return std::make_pair(alpha_min, alpha_maj);
+}
@@ -5,6 +5,7 @@
 #include <thundersvm/model/svc.h>
 
 #include "svm_solver.h"
+#include "dense_kernels.h"
 
 class svm_solver_thunder : public svm_solver<SVC>
 {
@@ -13,10 +14,27 @@ public:
         svm_solver_thunder(const svm_instance & instance);
 
         void train() override;
-        int predict(const std::vector<svm_node> & node) override;
+        std::unique_ptr<svm_solver<SVC>> clone() const override;
+        int predict(svm_row node) override;
 	std::vector<int> predict_batch(const svm_data & data) override;
 	void export_to_file(const string & path) override;
 	std::pair<std::vector<NodeID>, std::vector<NodeID>> get_SV() override;
+	std::pair<std::vector<double>, std::vector<double>> get_SV_alpha() override;
+
+private:
+	// dense copy of the SVs of a model for the single sample predict
+	struct dense_svs {
+		std::shared_ptr<SVC> source;
+		dense_matrix SV;
+		std::vector<double> coef;
+		double rho;
+		float gamma;
+	};
+
+	std::shared_ptr<const dense_svs> get_dense_svs();
+
+	// rebuilt whenever the model changes, shared by concurrent predict calls
+	std::shared_ptr<const dense_svs> predict_cache;
 };
 
 #endif /* SVM_SOLVER_THUNDER_H */
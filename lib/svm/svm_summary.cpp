@@ -3,10 +3,16 @@
 #include <cmath>
 #include <thundersvm/model/svc.h>
 
+#include "dense_model.h"
 #include "svm_summary.h"
 
 template<class T>
 svm_summary<T>::svm_summary(NodeID tp, NodeID tn, NodeID fp, NodeID fn) {
+        this->set_counts(tp, tn, fp, fn);
+}
+
+template<class T>
+void svm_summary<T>::set_counts(NodeID tp, NodeID tn, NodeID fp, NodeID fn) {
         this->TP = tp;
         this->FP = fp;
         this->TN = tn;
@@ -44,8 +50,8 @@ void svm_summary<T>::print() {
                   << " F1:" << this->F1
                   << " GM:" << this->Gmean
                   << std::setprecision(0)
-                  << " SV_min:" << this->SV_min.size()
-                  << " SV_maj:" << this->SV_maj.size()
+                  << " SV_min:" << this->num_SV_min()
+                  << " SV_maj:" << this->num_SV_maj()
                   << " TP:" << this->TP
                   << " TN:" << this->TN
                   << " FP:" << this->FP
@@ -61,21 +67,42 @@ void svm_summary<T>::print_short() {
         std::cout << std::setprecision(3)
                   << "  \tACC=" << this->Acc
                   << "\tGmean=" << this->Gmean
-                  << "\tSVs=" << this->SV_min.size() + this->SV_maj.size()
-                  << " (" << this->SV_min.size() << "," << this->SV_maj.size() <<")"
+                  << "\tSVs=" << this->num_SV_min() + this->num_SV_maj()
+                  << " (" << this->num_SV_min() << "," << this->num_SV_maj() <<")"
                   << std::endl;
 
         std::cout.unsetf(std::ios_base::floatfield);
 }
 
 template<class T>
-NodeID svm_summary<T>::num_SV_min() {
-        return this->SV_min.size();
+NodeID svm_summary<T>::num_SV_min() const {
+        return this->dropped ? this->dropped_SV_min : this->SV_min.size();
+}
+
+template<class T>
+NodeID svm_summary<T>::num_SV_maj() const {
+        return this->dropped ? this->dropped_SV_maj : this->SV_maj.size();
+}
+
+template<class T>
+void svm_summary<T>::drop_model() {
+        if (this->dropped) {
+                return;
+        }
+        this->dropped_SV_min = this->SV_min.size();
+        this->dropped_SV_maj = this->SV_maj.size();
+        this->dropped = true;
+
+        this->model.reset();
+        std::vector<NodeID>().swap(this->SV_min);
+        std::vector<NodeID>().swap(this->SV_maj);
+        std::vector<double>().swap(this->alpha_min);
+        std::vector<double>().swap(this->alpha_maj);
 }
 
 template<class T>
-NodeID svm_summary<T>::num_SV_maj() {
-        return this->SV_maj.size();
+bool svm_summary<T>::has_model() const {
+        return !this->dropped;
 }
 
 template<class T>
@@ -87,3 +114,4 @@ float svm_summary<T>::eval(const svm_instance & instance) {
 
 template class svm_summary<svm_model>;
 template class svm_summary<SVC>;
+template class svm_summary<dense_model>;
@@ -12,11 +12,18 @@ class svm_summary {
 public:
         svm_summary(NodeID tp, NodeID tn, NodeID fp, NodeID fn);
 
+        // sets the confusion counts and the scores derived from them
+        void set_counts(NodeID tp, NodeID tn, NodeID fp, NodeID fn);
+
         void print();
         void print_short();
 
-        NodeID num_SV_min();
-        NodeID num_SV_maj();
+        NodeID num_SV_min() const;
+        NodeID num_SV_maj() const;
+
+        // frees the model, the SV lists and alphas, the scores and SV counts stay
+        void drop_model();
+        bool has_model() const;
 
         bool operator > (const svm_summary new_) const{
                 return (this->Gmean > new_.Gmean);
@@ -41,11 +48,24 @@ public:
         std::vector<NodeID> SV_min;
         std::vector<NodeID> SV_maj;
 
+        // dual coefficients (alpha) of the SVs in the order of SV_min / SV_maj
+        std::vector<double> alpha_min;
+        std::vector<double> alpha_maj;
+
         double C;
         double gamma;
 
         double C_log;
         double gamma_log;
+
+        // dropped by racing, the scores are those of the validation slice
+        bool pruned = false;
+
+private:
+        // SV counts after drop_model
+        bool dropped = false;
+        NodeID dropped_SV_min = 0;
+        NodeID dropped_SV_maj = 0;
 };
  
 struct summary_cmp_better_gmean
@@ -85,7 +105,7 @@ struct summary_cmp_better_gmean_sv
                                 return false;
                         else{                                                    //similar gmean
                                 // a has less nSV than b which is better
-                                return (a.SV_min.size() + a.SV_maj.size() <  b.SV_min.size() + b.SV_maj.size());
+                                return (a.num_SV_min() + a.num_SV_maj() <  b.num_SV_min() + b.num_SV_maj());
                         }
                 }
         }
@@ -22,18 +22,20 @@ svm_result<T> ud_refinement<T>::step(const svm_data & min_sample, const svm_data
 
         std::vector<NodeID> sv_min = this->result.best().SV_min;
         std::vector<NodeID> sv_maj = this->result.best().SV_maj;
-        this->uncoarse(sv_min, sv_maj);
+        this->uncoarse(sv_min, sv_maj,
+                       this->result.best().alpha_min,
+                       this->result.best().alpha_maj);
 
         std::cout << "current level nodes"
-                  << " min " << this->uncoarsed_data_min.size()
-                  << " maj " << this->uncoarsed_data_maj.size()
+                  << " min " << this->uncoarsed_data_min->size()
+                  << " maj " << this->uncoarsed_data_maj->size()
                   << std::endl;
 
         svm_instance instance;
         instance.read_problem(this->uncoarsed_data_min, this->uncoarsed_data_maj);
-	std::unique_ptr<svm_solver<T>> solver = svm_solver_factory::create<T>(instance);
+	std::unique_ptr<svm_solver<T>> solver = this->create_solver(instance);
 
-        if (this->uncoarsed_data_min.size() + this->uncoarsed_data_maj.size() < this->num_skip_ms) {
+        if (this->uncoarsed_data_min->size() + this->uncoarsed_data_maj->size() < this->num_skip_ms) {
                 if (this->training_inherit) {
                         this->result = train_refinement(*solver, min_sample, maj_sample,
 							this->inherit_ud,
@@ -143,3 +145,4 @@ svm_result<T> ud_refinement<T>::train_refinement(svm_solver<T> & solver,
 
 template class ud_refinement<svm_model>;
 template class ud_refinement<SVC>;
+template class ud_refinement<dense_model>;
@@ -0,0 +1,299 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <omp.h>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "data_structure/graph_access.h"
+#include "partition/coarsening/clustering/low_diameter_clustering.h"
+#include "partition/coarsening/contraction.h"
+#include "partition/partition_config.h"
+#include "partition/uncoarsening/refinement/quotient_graph_refinement/complete_boundary.h"
+#include "tools/random_functions.h"
+
+namespace {
+
+// random graph with node weights, edge weights and feature vecs, with symmetric
+// every edge is inserted in both directions
+void random_graph(std::mt19937 & rng, NodeID n, int degree, bool symmetric, size_t features, graph_access & G) {
+        std::vector<std::vector<std::pair<NodeID, EdgeWeight>>> adjacency(n);
+        for (NodeID u = 0; u < n; u++) {
+                for (int k = 0; k < degree; k++) {
+                        NodeID v = rng() % n;
+                        if (v == u) continue;
+
+                        EdgeWeight weight = (rng() % 100) / 10.0;
+                        adjacency[u].push_back(std::make_pair(v, weight));
+                        if (symmetric) {
+                                adjacency[v].push_back(std::make_pair(u, weight));
+                        }
+                }
+        }
+
+        EdgeID m = 0;
+        for (const auto & edges : adjacency) {
+                m += edges.size();
+        }
+
+        std::uniform_real_distribution<double> value(-1, 1);
+        G.start_construction(n, m);
+        for (NodeID u = 0; u < n; u++) {
+                NodeID node = G.new_node();
+                G.setNodeWeight(node, 1 + rng() % 3);
+                G.setPartitionIndex(node, 0);
+
+                FeatureVec vec(features);
+                for (size_t i = 0; i < features; i++) {
+                        vec[i] = value(rng);
+                }
+                G.setFeatureVec(node, vec);
+
+                for (const auto & edge : adjacency[u]) {
+                        EdgeID e = G.new_edge(node, edge.first);
+                        G.setEdgeWeight(e, edge.second);
+                }
+        }
+        G.finish_construction();
+}
+
+// the first no_of_clusters nodes are in their own cluster, so every cluster is non-empty
+CoarseMapping random_clustering(std::mt19937 & rng, NodeID n, NodeID no_of_clusters) {
+        CoarseMapping mapping(n);
+        for (NodeID u = 0; u < n; u++) {
+                mapping[u] = u < no_of_clusters ? u : rng() % no_of_clusters;
+        }
+        return mapping;
+}
+
+std::map<NodeID, EdgeWeight> neighbours(graph_access & G, NodeID node) {
+        std::map<NodeID, EdgeWeight> result;
+        forall_out_edges(G, e, node) {
+                result[G.getEdgeTarget(e)] += G.getEdgeWeight(e);
+        } endfor
+        return result;
+}
+
+// Decomp-min one node at a time: a node becomes a center in round floor(delta) if it is
+// unvisited by then, an unvisited node joins the neighbouring center with the smallest
+// fractional shift (and id) of the previous round
+CoarseMapping sequential_low_diameter(graph_access & G, double beta, NodeID & no_of_clusters) {
+        const NodeID n = G.number_of_nodes();
+        std::vector<std::pair<double, double>> delta(n);
+        for (NodeID i = 0; i < n; i++) {
+                delta[i].first = random_functions::nextFromExp(beta);
+                delta[i].second = random_functions::next();
+        }
+
+        const NodeID NONE = std::numeric_limits<NodeID>::max();
+        std::vector<NodeID> center(n, NONE);
+        std::vector<NodeID> frontier;
+        NodeID visited = 0;
+        for (size_t round = 0; visited < n; round++) {
+                for (NodeID v = 0; v < n; v++) {
+                        if (center[v] == NONE && (size_t) delta[v].first <= round) {
+                                center[v] = v;
+                                frontier.push_back(v);
+                        }
+                }
+                visited += frontier.size();
+
+                std::map<NodeID, NodeID> claims;
+                for (NodeID v : frontier) {
+                        NodeID c = center[v];
+                        forall_out_edges(G, e, v) {
+                                NodeID w = G.getEdgeTarget(e);
+                                if (center[w] != NONE) continue;
+
+                                auto it = claims.find(w);
+                                if (it == claims.end()
+                                    || std::make_pair(delta[c].second, c) < std::make_pair(delta[it->second].second, it->second)) {
+                                        claims[w] = c;
+                                }
+                        } endfor
+                }
+
+                frontier.clear();
+                for (const auto & claim : claims) {
+                        center[claim.first] = claim.second;
+                        frontier.push_back(claim.first);
+                }
+        }
+
+        std::map<NodeID, NodeID> ids;
+        CoarseMapping mapping(n);
+        for (NodeID v = 0; v < n; v++) {
+                auto it = ids.emplace(center[v], ids.size()).first;
+                mapping[v] = it->second;
+        }
+        no_of_clusters = ids.size();
+        return mapping;
+}
+
+// true if both clusterings put the same nodes together, the ids may differ
+bool same_clusters(const CoarseMapping & a, const CoarseMapping & b) {
+        if (a.size() != b.size()) {
+                return false;
+        }
+        std::map<NodeID, NodeID> a_to_b;
+        std::map<NodeID, NodeID> b_to_a;
+        for (size_t i = 0; i < a.size(); i++) {
+                if (a_to_b.emplace(a[i], b[i]).first->second != b[i]
+                    || b_to_a.emplace(b[i], a[i]).first->second != a[i]) {
+                        return false;
+                }
+        }
+        return true;
+}
+
+void low_diameter(graph_access & G, double beta, int seed, CoarseMapping & mapping, NodeID & no_of_clusters) {
+        PartitionConfig config;
+        config.beta = beta;
+        Matching edge_matching;
+        NodePermutationMap permutation;
+
+        random_functions::setSeed(seed);
+        low_diameter_clustering clustering;
+        clustering.match(config, G, edge_matching, mapping, no_of_clusters, permutation);
+}
+
+}
+
+// build_quotient_graph has to give the graph contract_clustering used to get from
+// complete_boundary: the same node weights, adjacency and cut weights
+TEST(contraction, quotient_graph_matches_complete_boundary) {
+        std::mt19937 rng(1);
+        for (int round = 0; round < 10; round++) {
+                NodeID n = 2000 + rng() % 3000;
+                NodeID no_of_clusters = 1 + rng() % 400;
+
+                graph_access G;
+                random_graph(rng, n, 8, round % 2 == 1, 1, G);
+                CoarseMapping mapping = random_clustering(rng, n, no_of_clusters);
+
+                graph_access quotient;
+                contraction().build_quotient_graph(G, quotient, mapping, no_of_clusters);
+
+                G.set_partition_count(no_of_clusters);
+                forall_nodes(G, node) {
+                        G.setPartitionIndex(node, mapping[node]);
+                } endfor
+                graph_access expected;
+                complete_boundary boundary(&G);
+                boundary.build();
+                boundary.getUnderlyingQuotientGraph(expected);
+
+                ASSERT_EQ(expected.number_of_nodes(), quotient.number_of_nodes());
+                ASSERT_EQ(expected.number_of_edges(), quotient.number_of_edges());
+                forall_nodes(quotient, c) {
+                        EXPECT_EQ(expected.getNodeWeight(c), quotient.getNodeWeight(c));
+
+                        std::map<NodeID, EdgeWeight> cut = neighbours(quotient, c);
+                        std::map<NodeID, EdgeWeight> expected_cut = neighbours(expected, c);
+                        ASSERT_EQ(expected_cut.size(), cut.size());
+                        for (const auto & edge : expected_cut) {
+                                ASSERT_EQ(1u, cut.count(edge.first));
+                                EXPECT_NEAR(edge.second, cut[edge.first], 1e-6);
+                        }
+                } endfor
+        }
+}
+
+// the coarse nodes are the weighted centroids of their clusters, the edge
+// weights the inverse distances of the centroids
+TEST(contraction, contract_clustering_weights_centroids) {
+        std::mt19937 rng(2);
+        const size_t features = 4;
+        NodeID n = 3000;
+        NodeID no_of_clusters = 150;
+
+        graph_access G;
+        random_graph(rng, n, 6, true, features, G);
+        CoarseMapping mapping = random_clustering(rng, n, no_of_clusters);
+
+        PartitionConfig config;
+        config.combine = false;
+        graph_access coarser;
+        contraction().contract_clustering(config, G, coarser, Matching(), mapping, no_of_clusters, NodePermutationMap());
+
+        std::vector<std::vector<double>> centroid(no_of_clusters, std::vector<double>(features, 0));
+        std::vector<double> weight(no_of_clusters, 0);
+        forall_nodes(G, node) {
+                for (size_t i = 0; i < features; i++) {
+                        centroid[mapping[node]][i] += G.getNodeWeight(node) * G.getFeatureVec(node)[i];
+                }
+                weight[mapping[node]] += G.getNodeWeight(node);
+        } endfor
+
+        ASSERT_EQ(no_of_clusters, coarser.number_of_nodes());
+        forall_nodes(coarser, c) {
+                EXPECT_EQ(c, (NodeID) coarser.getPartitionIndex(c));
+                EXPECT_EQ(weight[c], coarser.getNodeWeight(c));
+                for (size_t i = 0; i < features; i++) {
+                        EXPECT_NEAR(centroid[c][i] / weight[c], coarser.getFeatureVec(c)[i], 1e-5);
+                }
+
+                forall_out_edges(coarser, e, c) {
+                        NodeID target = coarser.getEdgeTarget(e);
+                        double dist = 0;
+                        for (size_t i = 0; i < features; i++) {
+                                double diff = coarser.getFeatureVec(c)[i] - coarser.getFeatureVec(target)[i];
+                                dist += diff * diff;
+                        }
+                        EXPECT_NEAR(1 / std::sqrt(dist), coarser.getEdgeWeight(e), 1e-6 / std::sqrt(dist) + 1e-6);
+                } endfor
+        } endfor
+}
+
+// the frontier-based decomposition gives the clusters of the sequential Decomp-min
+TEST(low_diameter_clustering, matches_sequential_decomposition) {
+        std::mt19937 rng(3);
+        for (int round = 0; round < 6; round++) {
+                NodeID n = 2000 + rng() % 20000;
+                double beta = round % 2 == 1 ? 0.4 : 0.05;
+
+                graph_access G;
+                random_graph(rng, n, 3, true, 1, G);
+
+                CoarseMapping mapping;
+                NodeID no_of_clusters = 0;
+                low_diameter(G, beta, round, mapping, no_of_clusters);
+
+                random_functions::setSeed(round);
+                NodeID expected_clusters = 0;
+                CoarseMapping expected = sequential_low_diameter(G, beta, expected_clusters);
+
+                EXPECT_EQ(expected_clusters, no_of_clusters);
+                EXPECT_TRUE(same_clusters(expected, mapping));
+                for (NodeID node = 0; node < n; node++) {
+                        ASSERT_LT(mapping[node], no_of_clusters);
+                }
+        }
+}
+
+// claims are resolved by the smallest key, so the thread schedule does not matter
+TEST(low_diameter_clustering, independent_of_threads) {
+        std::mt19937 rng(4);
+        graph_access G;
+        random_graph(rng, 20000, 3, true, 1, G);
+
+        int threads = omp_get_max_threads();
+
+        CoarseMapping single;
+        NodeID single_clusters = 0;
+        omp_set_num_threads(1);
+        low_diameter(G, 0.1, 7, single, single_clusters);
+
+        CoarseMapping parallel;
+        NodeID parallel_clusters = 0;
+        omp_set_num_threads(std::max(threads, 4));
+        low_diameter(G, 0.1, 7, parallel, parallel_clusters);
+        omp_set_num_threads(threads);
+
+        EXPECT_EQ(single_clusters, parallel_clusters);
+        EXPECT_EQ(single, parallel);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "svm/dense_kernels.h"
+#include "svm/kernel_map.h"
+
+namespace {
+
+dense_matrix random_matrix(std::mt19937 & rng, size_t rows, size_t features) {
+        std::normal_distribution<float> value(0, 1);
+        dense_matrix M(rows, features);
+        std::vector<float> row(M.stride, 0);
+        for (size_t i = 0; i < rows; i++) {
+                double norm = 0;
+                for (size_t k = 0; k < features; k++) {
+                        row[k] = value(rng);
+                        norm += row[k] * row[k];
+                }
+                M.append_row(row.data(), norm);
+        }
+        return M;
+}
+
+double kernel(const dense_matrix & M, size_t i, size_t j, float gamma) {
+        double dist = 0;
+        for (size_t k = 0; k < M.features; k++) {
+                double diff = M.row(i)[k] - M.row(j)[k];
+                dist += diff * diff;
+        }
+        return std::exp(-gamma * dist);
+}
+
+// the kernel estimates z(x_i)^T z(x_j) of all pairs of rows of M
+std::vector<double> estimates(const kernel_map & map, const dense_matrix & M) {
+        dense_matrix Z = map.map_all(M);
+        std::vector<double> result;
+        for (size_t i = 0; i < M.rows; i++) {
+                for (size_t j = 0; j < M.rows; j++) {
+                        double dot = 0;
+                        for (size_t k = 0; k < map.dimension(); k++) {
+                                dot += Z.row(i)[k] * Z.row(j)[k];
+                        }
+                        result.push_back(dot);
+                }
+        }
+        return result;
+}
+
+}
+
+// on the landmarks the Nystroem kernel k_L^T K_LL^-1 k_L is exact
+TEST(kernel_map, nystroem_exact_on_landmarks) {
+        std::mt19937 rng(1);
+        const float gamma = 0.1;
+        dense_matrix landmarks = random_matrix(rng, 20, 5);
+        nystroem_map map(landmarks, gamma);
+        ASSERT_EQ(landmarks.rows, map.dimension());
+
+        std::vector<double> K = estimates(map, landmarks);
+        for (size_t i = 0; i < landmarks.rows; i++) {
+                for (size_t j = 0; j < landmarks.rows; j++) {
+                        EXPECT_NEAR(kernel(landmarks, i, j, gamma), K[i * landmarks.rows + j], 1e-3);
+                }
+        }
+}
+
+// the folded weights score every row as the linear model on z does
+TEST(kernel_map, nystroem_fold_matches_linear_model) {
+        std::mt19937 rng(2);
+        const float gamma = 0.1;
+        dense_matrix landmarks = random_matrix(rng, 20, 5);
+        dense_matrix X = random_matrix(rng, 50, 5);
+        nystroem_map map(landmarks, gamma);
+
+        std::normal_distribution<double> value(0, 1);
+        std::vector<double> w(map.dimension());
+        for (double & weight : w) {
+                weight = value(rng);
+        }
+        std::vector<double> folded = map.fold(w);
+        ASSERT_EQ(map.score_dimension(), folded.size());
+        ASSERT_EQ(landmarks.rows, map.kernel_centers()->rows);
+
+        std::vector<float> z(map.dimension());
+        std::vector<float> s(map.score_dimension());
+        for (size_t i = 0; i < X.rows; i++) {
+                map.map(X.row(i), X.norms[i], z.data());
+                map.score_features(X.row(i), X.norms[i], s.data());
+                double linear = 0;
+                double expansion = 0;
+                for (size_t k = 0; k < w.size(); k++) {
+                        linear += w[k] * z[k];
+                }
+                for (size_t k = 0; k < folded.size(); k++) {
+                        expansion += folded[k] * s[k];
+                }
+                EXPECT_NEAR(linear, expansion, 1e-3 * (1 + std::fabs(linear)));
+        }
+}
+
+// random Fourier features estimate the kernel with an error of about 1/sqrt(D)
+TEST(kernel_map, rff_estimates_kernel) {
+        std::mt19937 rng(3);
+        const float gamma = 0.1;
+        dense_matrix X = random_matrix(rng, 40, 5);
+
+        for (bool orthogonal : { false, true }) {
+                rff_map map(X.features, 4096, gamma, 7, orthogonal);
+                EXPECT_EQ(nullptr, map.kernel_centers());
+
+                std::vector<double> K = estimates(map, X);
+                double error = 0;
+                for (size_t i = 0; i < X.rows; i++) {
+                        for (size_t j = 0; j < X.rows; j++) {
+                                error += std::fabs(kernel(X, i, j, gamma) - K[i * X.rows + j]);
+                        }
+                }
+                EXPECT_LT(error / (X.rows * X.rows), 0.03) << "orthogonal " << orthogonal;
+        }
+}
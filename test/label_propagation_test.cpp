@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "data_structure/graph_access.h"
+#include "partition/coarsening/clustering/size_constraint_label_propagation.h"
+#include "partition/partition_config.h"
+
+namespace {
+
+void random_graph(std::mt19937 & rng, NodeID n, int degree, graph_access & G) {
+        std::vector<std::vector<NodeID>> adjacency(n);
+        for (NodeID u = 0; u < n; u++) {
+                for (int k = 0; k < degree; k++) {
+                        NodeID v = rng() % n;
+                        if (v == u) continue;
+
+                        adjacency[u].push_back(v);
+                        adjacency[v].push_back(u);
+                }
+        }
+
+        EdgeID m = 0;
+        for (const auto & edges : adjacency) {
+                m += edges.size();
+        }
+
+        G.start_construction(n, m);
+        for (NodeID u = 0; u < n; u++) {
+                NodeID node = G.new_node();
+                G.setNodeWeight(node, 1);
+                G.setPartitionIndex(node, 0);
+                for (NodeID v : adjacency[u]) {
+                        EdgeID e = G.new_edge(node, v);
+                        G.setEdgeWeight(e, 1);
+                }
+        }
+        G.finish_construction();
+}
+
+}
+
+// the runs of the ensemble clusterings of a level are one entry, a run
+// outside of match gets its own entry instead of being added to the last level
+TEST(label_propagation_stats, one_entry_per_level) {
+        std::mt19937 rng(1);
+        graph_access G;
+        random_graph(rng, 3000, 4, G);
+
+        PartitionConfig config;
+        config.upper_bound_partition = 50;
+        config.cluster_coarsening_factor = 1;
+        config.label_iterations = 5;
+        config.ensemble_clusterings = true;
+        config.number_of_clusterings = 3;
+
+        size_constraint_label_propagation lp;
+        Matching edge_matching;
+        CoarseMapping mapping;
+        NodeID no_of_clusters = 0;
+        NodePermutationMap permutation;
+
+        label_propagation_stats::reset();
+        lp.match(config, G, edge_matching, mapping, no_of_clusters, permutation);
+        lp.match(config, G, edge_matching, mapping, no_of_clusters, permutation);
+        ASSERT_EQ(2u, label_propagation_stats::runs().size());
+        for (const label_propagation_run & run : label_propagation_stats::runs()) {
+                EXPECT_EQ(G.number_of_nodes(), run.nodes);
+                // every clustering of the ensemble runs at least one iteration
+                EXPECT_GE(run.iterations, config.number_of_clusterings);
+        }
+        label_propagation_run level = label_propagation_stats::runs().back();
+
+        std::vector<NodeWeight> cluster_id(G.number_of_nodes());
+        NodeID no_of_blocks = 0;
+        lp.label_propagation(config, G, cluster_id, no_of_blocks);
+        ASSERT_EQ(3u, label_propagation_stats::runs().size());
+        EXPECT_EQ(level.iterations, label_propagation_stats::runs()[1].iterations);
+        EXPECT_EQ(level.visited, label_propagation_stats::runs()[1].visited);
+        EXPECT_GE(label_propagation_stats::runs()[2].iterations, 1);
+
+        label_propagation_stats::reset();
+        EXPECT_TRUE(label_propagation_stats::runs().empty());
+}
@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "svm/svm_instance.h"
+#include "svm/svm_solver_dense.h"
+
+namespace {
+
+// rows of features gaussian values around shift, some of them zero so the rows are sparse
+svm_data random_rows(std::mt19937 & rng, size_t rows, size_t features, double shift) {
+        std::normal_distribution<double> value(shift, 1);
+        svm_data data;
+        for (size_t i = 0; i < rows; i++) {
+                svm_feature row;
+                for (size_t k = 0; k < features; k++) {
+                        if (rng() % 4 == 0) continue;
+
+                        svm_node node;
+                        node.index = k + 1;
+                        node.value = value(rng);
+                        row.push_back(node);
+                }
+                svm_node end;
+                end.index = -1;
+                end.value = 0;
+                row.push_back(end);
+                data.push_back(svm_row(row));
+        }
+        return data;
+}
+
+svm_parameter libsvm_param(double C, double gamma) {
+        svm_parameter param;
+        param.svm_type = C_SVC;
+        param.kernel_type = RBF;
+        param.degree = 3;
+        param.gamma = gamma;
+        param.coef0 = 0;
+        param.nu = 0.5;
+        param.cache_size = 100;
+        param.C = C;
+        param.eps = 1e-3;
+        param.p = 0.1;
+        param.shrinking = 1;
+        param.probability = 0;
+        param.nr_weight = 0;
+        param.weight_label = NULL;
+        param.weight = NULL;
+        return param;
+}
+
+void print_null(const char *) {}
+
+int libsvm_label(const svm_model * model, svm_row row) {
+        double dec = 0;
+        svm_predict_values(model, row.data(), &dec);
+        return dec > 0 ? 1 : -1;
+}
+
+class svm_solver_dense_test : public ::testing::Test
+{
+protected:
+        void SetUp() override {
+                std::mt19937 rng(1);
+                this->min_data = random_rows(rng, 120, 6, 0.6);
+                this->maj_data = random_rows(rng, 280, 6, -0.3);
+                this->landmarks = std::make_shared<svm_data>(random_rows(rng, 30, 6, 0.1));
+                this->instance.read_problem(this->min_data, this->maj_data);
+        }
+
+        svm_data min_data;
+        svm_data maj_data;
+        std::shared_ptr<svm_data> landmarks;
+        svm_instance instance;
+};
+
+}
+
+// the SMO of the dense solver solves the same dual as libsvm: both stop at a
+// 1e-3 optimality gap, so alphas and rho agree up to that and the float kernel
+TEST_F(svm_solver_dense_test, smo_matches_libsvm) {
+        const double C = 4;
+        const double gamma = 0.25;
+
+        svm_solver_dense solver(this->instance);
+        solver.set_C(C);
+        solver.set_gamma(gamma);
+        solver.train();
+
+        svm_decision decision;
+        ASSERT_TRUE(solver.get_decision(decision));
+
+        svm_problem prob;
+        prob.l = this->instance.size();
+        prob.y = this->instance.label_data();
+        prob.x = this->instance.node_data();
+        svm_parameter param = libsvm_param(C, gamma);
+        svm_set_print_string_function(&print_null);
+        svm_model * model = svm_train(&prob, &param);
+        // label +1 comes first, so the coefficients have the same signs
+        ASSERT_EQ(1, model->label[0]);
+
+        std::vector<double> alpha(prob.l, 0);
+        for (int i = 0; i < model->l; i++) {
+                alpha[model->sv_indices[i] - 1] = model->sv_coef[0][i];
+        }
+        std::vector<double> dense_alpha(prob.l, 0);
+        for (size_t i = 0; i < decision.rows.size(); i++) {
+                dense_alpha[decision.rows[i]] = decision.coef[i];
+        }
+
+        EXPECT_NEAR(model->rho[0], decision.rho, 1e-3);
+        for (int i = 0; i < prob.l; i++) {
+                EXPECT_NEAR(alpha[i], dense_alpha[i], 1e-2) << "row " << i;
+        }
+
+        int disagree = 0;
+        for (const svm_data * data : { &this->min_data, &this->maj_data }) {
+                for (svm_row row : *data) {
+                        disagree += solver.predict(row) != libsvm_label(model, row);
+                }
+        }
+        EXPECT_LE(disagree, 2);
+
+        svm_free_and_destroy_model(&model);
+}
+
+// a Nystroem model is written as the RBF expansion over the landmarks,
+// libsvm has to predict every row as the solver does
+TEST_F(svm_solver_dense_test, nystroem_export_round_trips) {
+        svm_solver_dense solver(this->instance);
+        solver.set_C(4);
+        solver.set_gamma(0.3);
+
+        svm_approximation approximation;
+        approximation.kind = svm_approximation::NYSTROEM;
+        approximation.landmarks = this->landmarks;
+        ASSERT_TRUE(solver.set_approximation(approximation));
+        solver.train();
+
+        std::string path = testing::TempDir() + "svm_solver_dense_nystroem.model";
+        solver.export_to_file(path);
+        svm_model * model = svm_load_model(path.c_str());
+        ASSERT_NE(nullptr, model);
+        EXPECT_EQ((int) this->landmarks->size(), model->l);
+        EXPECT_EQ(model->l, model->nSV[0] + model->nSV[1]);
+
+        for (const svm_data * data : { &this->min_data, &this->maj_data }) {
+                for (svm_row row : *data) {
+                        EXPECT_EQ(solver.predict(row), libsvm_label(model, row));
+                }
+        }
+
+        svm_free_and_destroy_model(&model);
+        std::remove(path.c_str());
+}
+
+// random features have no kernel expansion, nothing is written
+TEST_F(svm_solver_dense_test, rff_export_is_refused) {
+        svm_solver_dense solver(this->instance);
+        solver.set_C(4);
+        solver.set_gamma(0.3);
+
+        svm_approximation approximation;
+        approximation.kind = svm_approximation::RFF;
+        approximation.dimension = 64;
+        ASSERT_TRUE(solver.set_approximation(approximation));
+        solver.train();
+
+        std::string path = testing::TempDir() + "svm_solver_dense_rff.model";
+        std::remove(path.c_str());
+        solver.export_to_file(path);
+        FILE * fp = std::fopen(path.c_str(), "r");
+        EXPECT_EQ(nullptr, fp);
+        if (fp != NULL) {
+                std::fclose(fp);
+        }
+}
+
+// merging SVs keeps at most budget of them and nearly the decision function
+TEST_F(svm_solver_dense_test, compact_keeps_budget) {
+        svm_solver_dense solver(this->instance);
+        solver.set_C(4);
+        solver.set_gamma(0.25);
+        solver.train();
+
+        std::pair<std::vector<int>, std::vector<int>> before = solver.predict_min_maj(this->min_data, this->maj_data);
+
+        // about half of the SVs
+        const size_t budget = 90;
+        ASSERT_TRUE(solver.compact(budget));
+
+        std::pair<std::vector<NodeID>, std::vector<NodeID>> SV = solver.get_SV();
+        EXPECT_LE(SV.first.size() + SV.second.size(), budget);
+        // the merged SVs are no instance rows
+        svm_decision decision;
+        EXPECT_FALSE(solver.get_decision(decision));
+
+        std::pair<std::vector<int>, std::vector<int>> after = solver.predict_min_maj(this->min_data, this->maj_data);
+        size_t disagree = 0;
+        for (size_t i = 0; i < this->min_data.size(); i++) {
+                disagree += before.first[i] != after.first[i];
+        }
+        for (size_t i = 0; i < this->maj_data.size(); i++) {
+                disagree += before.second[i] != after.second[i];
+        }
+        EXPECT_LE(disagree, (this->min_data.size() + this->maj_data.size()) / 20);
+}
+
+// a Nystroem model is compacted from its expansion over the landmarks, with a
+// budget above their number it keeps its labels. Random features can't be compacted
+TEST_F(svm_solver_dense_test, compact_approximate_models) {
+        svm_solver_dense solver(this->instance);
+        solver.set_C(4);
+        solver.set_gamma(0.3);
+
+        svm_approximation approximation;
+        approximation.kind = svm_approximation::NYSTROEM;
+        approximation.landmarks = this->landmarks;
+        ASSERT_TRUE(solver.set_approximation(approximation));
+        solver.train();
+
+        std::pair<std::vector<int>, std::vector<int>> before = solver.predict_min_maj(this->min_data, this->maj_data);
+        ASSERT_TRUE(solver.compact(this->landmarks->size()));
+
+        std::pair<std::vector<NodeID>, std::vector<NodeID>> SV = solver.get_SV();
+        EXPECT_EQ(this->landmarks->size(), SV.first.size() + SV.second.size());
+        svm_decision decision;
+        EXPECT_FALSE(solver.get_decision(decision));
+
+        std::pair<std::vector<int>, std::vector<int>> after = solver.predict_min_maj(this->min_data, this->maj_data);
+        size_t disagree = 0;
+        for (size_t i = 0; i < this->min_data.size(); i++) {
+                disagree += before.first[i] != after.first[i];
+        }
+        for (size_t i = 0; i < this->maj_data.size(); i++) {
+                disagree += before.second[i] != after.second[i];
+        }
+        EXPECT_LE(disagree, 2u);
+
+        approximation.kind = svm_approximation::RFF;
+        approximation.dimension = 64;
+        ASSERT_TRUE(solver.set_approximation(approximation));
+        solver.train();
+        EXPECT_FALSE(solver.compact(10));
+}